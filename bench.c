@@ -0,0 +1,563 @@
+/*
+ * File:   bench.c
+ *
+ * Benchmarks of the map and point modules. Writes to stdout one CSV
+ * line per measure:
+ *
+ *   benchmark,maze,size,n,ns_per_op,cells_per_s,peak_rss_kb
+ *
+ * For the map benchmarks n is the number of cells, an operation is a
+ * whole load or search and cells_per_s is n divided by its time. For
+ * the point benchmarks n is the number of points and an operation is
+ * the work done on one of them (cells_per_s is empty). For the batch
+ * benchmark n is the number of queries, an operation is one query and
+ * cells_per_s counts the cells of the map once per query. Every maze has
+ * a path from its input to its output. Each measure is the best of
+ * several repetitions and the random generator has a fixed seed, so two
+ * runs on the same machine give comparable numbers.
+ *
+ * Usage: ./bench [max_side [max_points [repetitions]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "map.h"
+#include "point.h"
+#include "stack_fDoble.h"
+#include "stack_sort.h"
+#include "mapbatch.h"
+#include "mapbfs.h"
+#include "mapplan.h"
+
+#define MIN_SIDE 64
+#define MAX_SIDE 8192
+#define MIN_POINTS 1000
+#define MAX_POINTS 10000000
+#define REPETITIONS 3
+/* Lado maximo para los mapas con un Point por celda (unos 24 bytes por celda) */
+#define FULL_MAX_SIDE 4096
+/* Coordenadas de los puntos aleatorios, como en p2_e1a */
+#define MAX_RAND 101
+/* Consultas de cada tanda de mapbatch_run */
+#define BATCH_QUERIES 256
+/* Laberintos aleatorios generados como mucho hasta encontrar uno con salida */
+#define MAZE_TRIES 100
+
+typedef enum { MAZE_RANDOM, MAZE_OPEN, MAZE_SERPENTINE } MazeType;
+
+static const char *maze_names[] = { "random", "open", "serpentine" };
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+/* xorshift64: rapido y con la misma secuencia en todas las plataformas */
+static uint64_t rng_next () {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double now () {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static long peak_rss () {
+    struct rusage ru;
+
+    if(getrusage(RUSAGE_SELF, &ru) != 0) {
+        return -1;
+    }
+    return ru.ru_maxrss;
+}
+
+static void report_map (const char *bench, MazeType type, int side, double ns) {
+    double cells = (double) side * side;
+
+    fprintf(stdout, "%s,%s,%d,%.0f,%.1f,%.0f,%ld\n", bench, maze_names[type], side, cells, ns, cells / ns * 1e9, peak_rss());
+    fflush(stdout);
+}
+
+static void report_points (const char *bench, size_t n, double ns) {
+    fprintf(stdout, "%s,,,%lu,%.3f,,%ld\n", bench, (unsigned long) n, ns / n, peak_rss());
+    fflush(stdout);
+}
+
+/* Escribe en pf un laberinto side x side con la entrada arriba a la izquierda y la salida abajo a la derecha */
+static Status write_maze (FILE *pf, MazeType type, int side) {
+    char *row;
+    int x, y;
+
+    row = (char*) malloc(side + 1);
+    if(!row) {
+        return ERROR;
+    }
+    row[side] = '\n';
+
+    fprintf(pf, "%d %d\n", side, side);
+    for(y=0; y < side; y++) {
+        for(x=0; x < side; x++) {
+            switch(type) {
+                case MAZE_RANDOM:
+                    row[x] = (rng_next() % 100) < 30 ? BARRIER : SPACE;
+                    break;
+                case MAZE_OPEN:
+                    row[x] = SPACE;
+                    break;
+                default:
+                    //filas impares de muro con un hueco alternando a cada lado: el camino recorre todo
+                    if(y % 2 == 0 || y == side - 1) {
+                        row[x] = SPACE;
+                    }
+                    else {
+                        row[x] = (y % 4 == 1 ? x == side - 1 : x == 0) ? SPACE : BARRIER;
+                    }
+                    break;
+            }
+        }
+        if(y == 0) {
+            row[0] = INPUT;
+        }
+        if(y == side - 1) {
+            row[side - 1] = OUTPUT;
+        }
+        if(fwrite(row, 1, side + 1, pf) != (size_t)(side + 1)) {
+            free(row);
+            return ERROR;
+        }
+    }
+
+    free(row);
+    return fflush(pf) == 0 ? OK : ERROR;
+}
+
+/* Todas las busquedas tienen que dar el mismo resultado y la misma 
+   longitud que BFS: una que devuelva un camino mas corto o ninguno solo
+   pareceria mas rapida */
+static void check_search (const char *bench, MazeType type, int side, Status st, size_t len, Status ref_st, size_t ref_len) {
+    if(st != ref_st || (st == OK && len != ref_len)) {
+        fprintf(stderr, "%s,%s,%d: resultado %d con %lu celdas, bfs da %d con %lu\n", bench, maze_names[type], side,
+                (int) st, (unsigned long) len, (int) ref_st, (unsigned long) ref_len);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static Map * load (FILE *pf, Bool compact) {
+    rewind(pf);
+    return compact == TRUE ? map_readFromFileCompact(pf) : map_readFromFile(pf);
+}
+
+/* Como write_maze, pero vuelve a generar el laberinto con la siguiente parte
+   de la secuencia aleatoria hasta que la salida es alcanzable desde la
+   entrada; si no, las busquedas terminan sin recorrer nada */
+static Status write_solvable_maze (FILE *pf, MazeType type, int side) {
+    Map *mp;
+    Bool reachable;
+    int tries;
+
+    for(tries=0; tries < MAZE_TRIES; tries++) {
+        rewind(pf);
+        if(ftruncate(fileno(pf), 0) != 0 || write_maze(pf, type, side) == ERROR) {
+            return ERROR;
+        }
+
+        mp = load(pf, TRUE);
+        if(!mp) {
+            return ERROR;
+        }
+        reachable = map_isReachable(mp, map_getInputIndex(mp), map_getOutputIndex(mp));
+        map_free(mp);
+        if(reachable == TRUE) {
+            return OK;
+        }
+    }
+
+    return ERROR;
+}
+
+/* Tanda de BFS entre celdas libres al azar con un hilo por procesador */
+static void bench_batch (const Map *mp, MazeType type, int side, int reps) {
+    MapBatch *b;
+    MapQuery q[BATCH_QUERIES];
+    MapCell cell;
+    uint32_t cells = (uint32_t) side * side, i;
+    double t, best, total;
+    int k, r, tries;
+
+    b = mapbatch_new(mp, 0);
+    if(!b) {
+        return;
+    }
+
+    for(k=0; k < BATCH_QUERIES; k++) {
+        for(tries=0; tries < 2; tries++) {
+            do {
+                i = (uint32_t)(rng_next() % cells);
+            } while(map_getCellByIndex(mp, i, &cell) == OK && cell.symbol == BARRIER);
+            if(tries == 0) q[k].src = i;
+            else q[k].dst = i;
+        }
+    }
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        mapbatch_run(b, q, BATCH_QUERIES, map_bfsBetween);
+        t = now() - t;
+        mapbatch_freePaths(q, BATCH_QUERIES);
+        if(r == 0 || t < best) best = t;
+    }
+
+    total = (double) cells * BATCH_QUERIES;
+    fprintf(stdout, "batch_bfs_%dthreads,%s,%d,%d,%.1f,%.0f,%ld\n", mapbatch_getNthreads(b), maze_names[type], side,
+            BATCH_QUERIES, best / BATCH_QUERIES, total / best * 1e9, peak_rss());
+    fflush(stdout);
+
+    mapbatch_free(b);
+}
+
+/* Planificador incremental: primera busqueda y replanificacion tras cerrar
+   y volver a abrir una celda del camino */
+static void bench_planner (Map *mp, MazeType type, int side, int reps) {
+    MapPlanner *pl;
+    MapCell cell;
+    const uint32_t *route;
+    size_t len;
+    double t, best;
+    int r;
+
+    pl = mapplanner_new(mp, map_getInputIndex(mp), map_getOutputIndex(mp));
+    if(!pl) {
+        return;
+    }
+
+    t = now();
+    if(mapplanner_path(pl, &route, &len) != OK || len < 3) {
+        mapplanner_free(pl);
+        return;
+    }
+    report_map("planner_initial", type, side, now() - t);
+
+    map_getCellByIndex(mp, route[len / 2], &cell);
+    for(best=0, r=0; r < reps; r++) {
+        map_setCellSymbol(mp, cell.x, cell.y, BARRIER);
+        t = now();
+        mapplanner_path(pl, &route, &len);
+        t = now() - t;
+        map_setCellSymbol(mp, cell.x, cell.y, cell.symbol);
+        mapplanner_path(pl, &route, &len);
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("planner_replan", type, side, best);
+
+    mapplanner_free(pl);
+}
+
+typedef Status (*SearchFunction) (const Map *, MapWorkspace *, const uint32_t **, size_t *);
+
+static void bench_maze (MazeType type, int side, int reps, const char *path) {
+    FILE *pf, *null;
+    Map *mp = NULL, *full = NULL;
+    MapWorkspace *ws;
+    MapCell cell;
+    const uint32_t *route;
+    uint32_t *dist;
+    size_t len, ref_len = 0;
+    Status st = ERROR, ref_st = ERROR;
+    double t, best;
+    int r, k;
+    SearchFunction searches[] = { map_bfs, map_astar, map_astarBidirectional, map_jps };
+    const char *names[] = { "bfs", "astar", "astar_bidirectional", "jps" };
+
+    pf = fopen(path, "w+");
+    if(!pf || write_solvable_maze(pf, type, side) == ERROR) {
+        fprintf(stderr, "Error escribiendo el laberinto %s %d\n", maze_names[type], side);
+        if(pf) fclose(pf);
+        return;
+    }
+
+    //carga en los dos modos
+    for(best=0, r=0; r < reps; r++) {
+        map_free(mp);
+        t = now();
+        mp = load(pf, TRUE);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("load_compact", type, side, best);
+
+    if(side <= FULL_MAX_SIDE) {
+        for(best=0, r=0; r < reps; r++) {
+            map_free(full);
+            t = now();
+            full = load(pf, FALSE);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("map_readFromFile", type, side, best);
+    }
+    fclose(pf);
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        map_free(map_mmapFile(path, TRUE, NULL, NULL));
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("mmap", type, side, best);
+
+    if(!mp) {
+        map_free(full);
+        return;
+    }
+
+    //DFS clasica, que imprime cada punto visitado
+    null = fopen("/dev/null", "w");
+    if(full && null) {
+        for(best=0, r=0; r < reps; r++) {
+            t = now();
+            map_dfs(null, full);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("map_dfs", type, side, best);
+    }
+    if(null) fclose(null);
+    map_free(full);
+
+    ws = map_workspaceNew(mp);
+    if(!ws) {
+        map_free(mp);
+        return;
+    }
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        map_dfsWorkspace(NULL, mp, ws);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("dfs_workspace", type, side, best);
+
+    for(k=0; k < (int)(sizeof(searches) / sizeof(searches[0])); k++) {
+        for(best=0, r=0; r < reps; r++) {
+            t = now();
+            st = searches[k](mp, ws, &route, &len);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map(names[k], type, side, best);
+
+        //searches[0] es BFS, la referencia de las demas
+        if(k == 0) {
+            ref_st = st;
+            ref_len = len;
+        }
+        check_search(names[k], type, side, st, len, ref_st, ref_len);
+    }
+
+    //campo de distancias a la salida; reescribir la entrada lo deja desactualizado
+    if(map_getInputCell(mp, &cell) == OK) {
+        for(best=0, r=0; r < reps; r++) {
+            map_setCellSymbol(mp, cell.x, cell.y, cell.symbol);
+            t = now();
+            map_distanceField(mp, NULL, 0);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("distance_field", type, side, best);
+
+        for(best=0, r=0; r < reps; r++) {
+            t = now();
+            st = map_fieldPath(mp, ws, map_getInputIndex(mp), &route, &len);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("field_path", type, side, best);
+        check_search("field_path", type, side, st, len, ref_st, ref_len);
+    }
+
+    //componentes conexas: etiquetado completo y consulta de alcanzabilidad
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        map_labelComponents(mp);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("label_components", type, side, best);
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        map_isReachable(mp, map_getInputIndex(mp), map_getOutputIndex(mp));
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_map("is_reachable", type, side, best);
+
+    bench_planner(mp, type, side, reps);
+
+    map_workspaceFree(ws);
+
+    //distancias a todo el mapa, en serie y en paralelo
+    dist = (uint32_t*) malloc((size_t) side * side * sizeof(uint32_t));
+    if(dist) {
+        for(best=0, r=0; r < reps; r++) {
+            t = now();
+            mapbfs_distances(mp, map_getInputIndex(mp), dist);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("mapbfs_distances", type, side, best);
+
+        for(best=0, r=0; r < reps; r++) {
+            t = now();
+            mapbfs_parallel(mp, map_getInputIndex(mp), dist, 0);
+            t = now() - t;
+            if(r == 0 || t < best) best = t;
+        }
+        report_map("mapbfs_parallel", type, side, best);
+        free(dist);
+    }
+
+    bench_batch(mp, type, side, reps);
+    map_free(mp);
+}
+
+static void bench_points (size_t n, int reps) {
+    Point **pts, *origin;
+    const Point *nearest[10];
+    Stack *s;
+    double *dist, d, t, best;
+    volatile double sink = 0;
+    volatile int isink = 0;
+    size_t i;
+    int r;
+
+    pts = (Point**) malloc(n * sizeof(Point*));
+    dist = (double*) malloc(n * sizeof(double));
+    origin = point_new(0, 0, BARRIER);
+    s = stack_init();
+    if(!pts || !dist || !origin || !s) {
+        free(pts);
+        free(dist);
+        point_free(origin);
+        stack_free(s);
+        return;
+    }
+
+    for(i=0; i < n; i++) {
+        pts[i] = point_new((int)(rng_next() % MAX_RAND), (int)(rng_next() % MAX_RAND), BARRIER);
+        if(!pts[i]) {
+            n = i;
+            break;
+        }
+    }
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        for(i=0; i < n; i++) {
+            point_euDistance(origin, pts[i], &d);
+            sink += d;
+        }
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("point_euDistance", n, best);
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        point_euDistanceBatch(origin, (const Point * const *) pts, n, dist);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("point_euDistanceBatch", n, best);
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        for(i=1; i < n; i++) {
+            isink += point_cmpEuDistance(pts[i - 1], pts[i]);
+        }
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("point_cmpEuDistance", n, best);
+
+    for(best=0, r=0; r < reps; r++) {
+        t = now();
+        point_nearestK(origin, (const Point * const *) pts, n, 10, nearest);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("point_nearestK_10", n, best);
+
+    //ordenaciones: se rellena la pila en cada repeticion, fuera de la medida
+    for(best=0, r=0; r < reps; r++) {
+        while(stack_isEmpty(s) == FALSE) stack_pop(s);
+        for(i=0; i < n; i++) stack_push(s, pts[i]);
+        t = now();
+        stack_sort(s, point_cmpEuDistance);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("stack_sort", n, best);
+
+    for(best=0, r=0; r < reps; r++) {
+        while(stack_isEmpty(s) == FALSE) stack_pop(s);
+        for(i=0; i < n; i++) stack_push(s, pts[i]);
+        t = now();
+        stack_sortPoints(s, origin);
+        t = now() - t;
+        if(r == 0 || t < best) best = t;
+    }
+    report_points("stack_sortPoints", n, best);
+
+    for(i=0; i < n; i++) {
+        point_free(pts[i]);
+    }
+    free(pts);
+    free(dist);
+    point_free(origin);
+    stack_free(s);
+}
+
+int main (int argc, char *argv[]) {
+    int max_side = MAX_SIDE, reps = REPETITIONS, side, type, fd;
+    size_t max_points = MAX_POINTS, n;
+    char path[] = "/tmp/bench_mazeXXXXXX";
+
+    if(argc > 1) max_side = atoi(argv[1]);
+    if(argc > 2) max_points = (size_t) atol(argv[2]);
+    if(argc > 3) reps = atoi(argv[3]);
+    if(max_side < 0 || reps <= 0) {
+        fprintf(stderr, "Uso: %s [lado_maximo [puntos_maximos [repeticiones]]]\n", argv[0]);
+        return 1;
+    }
+
+    fd = mkstemp(path);
+    if(fd < 0) {
+        fprintf(stderr, "Error creando el fichero temporal\n");
+        return 1;
+    }
+    close(fd);
+
+    fprintf(stdout, "benchmark,maze,size,n,ns_per_op,cells_per_s,peak_rss_kb\n");
+
+    for(side=MIN_SIDE; side <= max_side; side *= 2) {
+        for(type=MAZE_RANDOM; type <= MAZE_SERPENTINE; type++) {
+            bench_maze((MazeType) type, side, reps, path);
+        }
+    }
+    remove(path);
+
+    for(n=MIN_POINTS; n <= max_points; n *= 10) {
+        bench_points(n, reps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include "heap.h"
+
+/* Los nodos guardan clave y elemento juntos para comparar sin saltos de memoria */
+typedef struct {
+    uint64_t key;
+    uint32_t item;
+} HeapNode;
+
+struct _Heap {
+    size_t capacity; // number of different items
+    size_t size; // number of items in the heap
+    HeapNode *nodes; // binary heap, nodes[0] has the lowest key
+    uint32_t *pos; // position of each item in nodes, HEAP_NOITEM if it is not in the heap
+};
+
+Heap * heap_new (size_t capacity) {
+    Heap *h;
+    size_t i;
+
+    if(capacity >= HEAP_NOITEM) {
+        return NULL;
+    }
+
+    h = (Heap*) malloc(sizeof(Heap));
+    if(!h) {
+        return NULL;
+    }
+
+    h->capacity = capacity;
+    h->size = 0;
+    h->nodes = (HeapNode*) malloc((capacity ? capacity : 1) * sizeof(HeapNode));
+    h->pos = (uint32_t*) malloc((capacity ? capacity : 1) * sizeof(uint32_t));
+    if(!h->nodes || !h->pos) {
+        heap_free(h);
+        return NULL;
+    }
+
+    for(i=0; i < capacity; i++) {
+        h->pos[i] = HEAP_NOITEM;
+    }
+
+    return h;
+}
+
+void heap_free (Heap *h) {
+    if(!h) {
+        return;
+    }
+
+    free(h->nodes);
+    free(h->pos);
+    free(h);
+}
+
+void heap_clear (Heap *h) {
+    size_t i;
+
+    if(!h) {
+        return;
+    }
+
+    for(i=0; i < h->size; i++) {
+        h->pos[h->nodes[i].item] = HEAP_NOITEM;
+    }
+    h->size = 0;
+}
+
+Bool heap_isEmpty (const Heap *h) {
+    if(!h || h->size == 0) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+size_t heap_size (const Heap *h) {
+    if(!h) {
+        return 0;
+    }
+
+    return h->size;
+}
+
+Bool heap_contains (const Heap *h, uint32_t item) {
+    if(!h || item >= h->capacity) {
+        return FALSE;
+    }
+
+    return h->pos[item] != HEAP_NOITEM ? TRUE : FALSE;
+}
+
+/* Sube el nodo de la posicion i hasta su sitio */
+static void _heap_up (Heap *h, size_t i) {
+    HeapNode node = h->nodes[i];
+    size_t parent;
+
+    while(i > 0) {
+        parent = (i - 1) / 2;
+        if(h->nodes[parent].key <= node.key) {
+            break;
+        }
+        h->nodes[i] = h->nodes[parent];
+        h->pos[h->nodes[i].item] = (uint32_t) i;
+        i = parent;
+    }
+
+    h->nodes[i] = node;
+    h->pos[node.item] = (uint32_t) i;
+}
+
+/* Baja el nodo de la posicion i hasta su sitio */
+static void _heap_down (Heap *h, size_t i) {
+    HeapNode node = h->nodes[i];
+    size_t child;
+
+    while((child = 2 * i + 1) < h->size) {
+        if(child + 1 < h->size && h->nodes[child + 1].key < h->nodes[child].key) {
+            child++;
+        }
+        if(node.key <= h->nodes[child].key) {
+            break;
+        }
+        h->nodes[i] = h->nodes[child];
+        h->pos[h->nodes[i].item] = (uint32_t) i;
+        i = child;
+    }
+
+    h->nodes[i] = node;
+    h->pos[node.item] = (uint32_t) i;
+}
+
+Status heap_push (Heap *h, uint32_t item, uint64_t key) {
+    size_t i;
+    uint64_t old;
+
+    if(!h || item >= h->capacity) {
+        return ERROR;
+    }
+
+    if(h->pos[item] == HEAP_NOITEM) {
+        i = h->size++;
+        h->nodes[i].key = key;
+        h->nodes[i].item = item;
+        _heap_up(h, i);
+        return OK;
+    }
+
+    i = h->pos[item];
+    old = h->nodes[i].key;
+    h->nodes[i].key = key;
+    if(key < old) {
+        _heap_up(h, i);
+    }
+    else {
+        _heap_down(h, i);
+    }
+
+    return OK;
+}
+
+uint32_t heap_pop (Heap *h) {
+    uint32_t item;
+
+    if(!h || h->size == 0) {
+        return HEAP_NOITEM;
+    }
+
+    item = h->nodes[0].item;
+    h->pos[item] = HEAP_NOITEM;
+    h->size--;
+    if(h->size > 0) {
+        h->nodes[0] = h->nodes[h->size];
+        _heap_down(h, 0);
+    }
+
+    return item;
+}
+
+uint64_t heap_topKey (const Heap *h) {
+    if(!h || h->size == 0) {
+        return UINT64_MAX;
+    }
+
+    return h->nodes[0].key;
+}
+
+Status heap_remove (Heap *h, uint32_t item) {
+    size_t i;
+
+    if(!h || item >= h->capacity || h->pos[item] == HEAP_NOITEM) {
+        return ERROR;
+    }
+
+    i = h->pos[item];
+    h->pos[item] = HEAP_NOITEM;
+    h->size--;
+    if(i < h->size) {
+        //el ultimo nodo ocupa el hueco y se recoloca hacia arriba o hacia abajo
+        h->nodes[i] = h->nodes[h->size];
+        item = h->nodes[i].item;
+        _heap_up(h, i);
+        if(h->pos[item] == i) {
+            _heap_down(h, i);
+        }
+    }
+
+    return OK;
+}
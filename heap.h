@@ -0,0 +1,111 @@
+/**
+ * @file  heap.h
+ * @brief Indexed binary min-heap
+ *
+ * @details Priority queue of the items 0..capacity-1 (for instance the
+ * cell indices of a map) ordered by a 64-bit key. Every item is at most
+ * once in the heap and its key can be lowered or raised in O(log n), 
+ * which is what A* like searches need. Composite priorities can be
+ * packed in the key, e.g. (f << 32) | h.
+ */
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "types.h"
+
+/* Value returned by heap_pop when the heap is empty */
+#define HEAP_NOITEM UINT32_MAX
+
+typedef struct _Heap Heap;
+
+/**
+ * @brief Creates an empty heap for the items 0..capacity-1.
+ *
+ * @param capacity Number of different items
+ *
+ * @return The new heap or NULL if there is not enough memory.
+ */
+Heap * heap_new (size_t capacity);
+
+/**
+ * @brief Frees a heap.
+ *
+ * @param h Pointer to the heap
+ */
+void heap_free (Heap *h);
+
+/**
+ * @brief Removes all the items from the heap.
+ *
+ * Time complexity: O(size), no memory is released.
+ * @param h Pointer to the heap
+ */
+void heap_clear (Heap *h);
+
+/**
+ * @brief Returns whether the heap is empty.
+ *
+ * @param h Pointer to the heap
+ * @return TRUE or FALSE, TRUE also in case of error
+ */
+Bool heap_isEmpty (const Heap *h);
+
+/**
+ * @brief Returns the number of items in the heap.
+ *
+ * @param h Pointer to the heap
+ * @return the size
+ */
+size_t heap_size (const Heap *h);
+
+/**
+ * @brief Returns whether an item is in the heap.
+ *
+ * @param h Pointer to the heap
+ * @param item Item
+ * @return TRUE or FALSE
+ */
+Bool heap_contains (const Heap *h, uint32_t item);
+
+/**
+ * @brief Inserts an item or changes its key if it is already in the heap.
+ *
+ * Time complexity: O(log n).
+ * @param h Pointer to the heap
+ * @param item Item, lower than the heap capacity
+ * @param key New key of the item
+ * @return OK or ERROR in case of invalid parameters
+ */
+Status heap_push (Heap *h, uint32_t item, uint64_t key);
+
+/**
+ * @brief Extracts the item with the lowest key.
+ *
+ * Time complexity: O(log n).
+ * @param h Pointer to the heap
+ * @return The item or HEAP_NOITEM if the heap is empty
+ */
+uint32_t heap_pop (Heap *h);
+
+/**
+ * @brief Returns the lowest key of the heap.
+ *
+ * @param h Pointer to the heap
+ * @return The key or UINT64_MAX if the heap is empty
+ */
+uint64_t heap_topKey (const Heap *h);
+
+/**
+ * @brief Removes an item from the heap.
+ *
+ * Time complexity: O(log n).
+ * @param h Pointer to the heap
+ * @param item Item to remove
+ * @return OK, or ERROR if the item is not in the heap
+ */
+Status heap_remove (Heap *h, uint32_t item);
+
+#endif /* HEAP_H */
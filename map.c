@@ -1,21 +1,94 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "map.h"
+#include "stack_fDoble.h"
+#include "heap.h"
+
+/* Con -DPOINT_FAST los accesores de Point se expanden en linea (sin 
+   comprobaciones: solo para puntos ya validados) */
+#ifdef POINT_FAST
+#include "point_inline.h"
+#define MAP_POINT_X(p) point_getCoordinateXUnchecked(p)
+#define MAP_POINT_Y(p) point_getCoordinateYUnchecked(p)
+#define MAP_POINT_SYMBOL(p) point_getSymbolUnchecked(p)
+#else
+#define MAP_POINT_X(p) point_getCoordinateX(p)
+#define MAP_POINT_Y(p) point_getCoordinateY(p)
+#define MAP_POINT_SYMBOL(p) point_getSymbol(p)
+#endif
 
-#define MAX_NCOLS 64 // Maximum map cols
-#define MAX_NROWS 64 // Maximum map rows
-#define MAX_BUFFER 64 // Maximum file line size
 struct _Map {
     unsigned int nrows, ncols;
-    Point *array[MAX_NROWS][MAX_NCOLS]; // array with the Map points
+    Point **cells; // nrows*ncols Map points, row-major: cell (x, y) is cells[y*ncols + x]
+    Point *block; // points owned by the map, allocated at once (NULL if none)
     Point *input, *output; // points input/output
+    Bool compact; // compact mode: no Point objects, only the planes below
+    uint8_t *symbols; // compact mode: one symbol per cell, row-major, rows stride bytes apart
+    size_t stride; // compact mode: distance between rows in symbols (ncols, or more for mapped files)
+    void *mapping; // mapped file the symbols point into (NULL if none)
+    size_t mapping_size; // size of the mapping
+    uint64_t *visited; // compact mode: one visited bit per cell
+    uint8_t *nbmask; // per cell, bit MAP_MASK(pos) set if the neighboor at pos is in the map and passable (NULL for mapped files)
+    size_t input_idx, output_idx; // index of the input/output cells, MAP_NOCELL if unset
+    uint32_t *field; // cached distance field, one distance per cell (NULL until first computed)
+    uint32_t *field_src; // sources of the field (NULL: the output cell)
+    size_t field_nsrc; // number of sources in field_src
+    Bool field_valid; // FALSE if a cell has changed since the field was computed
+    uint32_t *comp; // union-find over the passable cells: parent of each cell, always a lower index (MAP_NOINDEX for barriers, NULL until labelled)
+    Bool comp_valid; // FALSE if a passable cell has become a barrier since the labelling
+    P_map_cellChanged listener; // called after a cell changes (NULL if none)
+    void *listener_data; // first argument of listener
+    PointOwner owner; // owner of the points of the map: point_setSymbol on them ends in _map_cellChanged
 };
 
-Map * map_new (unsigned int nrows, unsigned int ncols) {
+struct _MapWorkspace {
+    size_t capacity; // maximum number of cells of the maps it can search
+    Stack *stack; // DFS stack, its elements point into mark
+    uint32_t *mark; // mark[i] == gen if cell i has been visited in the current search
+    uint32_t gen; // current search generation
+    uint32_t *pred; // BFS: predecessor of each visited cell (allocated on first use)
+    uint32_t *queue; // BFS: ring buffer queue, reused to return the path
+    uint32_t *cost; // A*: cost from the start of each reached cell
+    Heap *heap; // A*: open set
+    uint32_t *mark2, *pred2, *cost2; // bidirectional A*: backward search state
+    Heap *heap2; // bidirectional A*: backward open set
+    size_t expanded; // cells expanded by the last search
+};
+
+/* Indice de la celda (x, y) dentro de cells/nbmask */
+#define MAP_INDEX(mp, x, y) ((size_t)(y) * (mp)->ncols + (size_t)(x))
+/* Simbolo de la celda (x, y) de un mapa compacto */
+#define MAP_SYMBOL(mp, x, y) ((mp)->symbols[(size_t)(y) * (mp)->stride + (size_t)(x)])
+#define MAP_NOCELL ((size_t)-1)
+
+/* Acceso al bitset de visitados */
+#define BIT_GET(bs, i) (((bs)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BIT_SET(bs, i) ((bs)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+#define BIT_CLEAR(bs, i) ((bs)[(i) >> 6] &= ~((uint64_t)1 << ((i) & 63)))
+
+static void _map_buildMasks (Map *mp);
+static void _map_pointChanged (void *data, const Point *p);
+static Bool _map_knownUnreachable (const Map *mp, size_t src, size_t dst);
+static void _map_maskRow (Map *mp, size_t y, const char *prev, const char *cur, const char *next);
+
+/* Reserva un mapa normal, compacto o proyectado de fichero (mapped: compacto
+   sin plano de simbolos ni mascaras propios) */
+static Map * _map_alloc (unsigned int nrows, unsigned int ncols, Bool compact, Bool mapped) {
     Map *new_map = NULL;
-    int i, j;
+    size_t n;
+
+    /* los indices de celda tienen que caber en un uint32_t */
+    if(ncols && nrows >= MAP_NOINDEX / ncols) {
+        return NULL;
+    }
 
     new_map = (Map*) malloc(sizeof(Map));
-    if(!new_map || nrows >= MAX_NROWS || ncols >= MAX_NCOLS) {
+    if(!new_map) {
         return NULL;
     }
 
@@ -23,32 +96,292 @@ Map * map_new (unsigned int nrows, unsigned int ncols) {
     new_map->ncols = ncols;
     new_map->input = NULL;
     new_map->output = NULL;
-    for(i=0; i < MAX_NROWS; i++) {
-        for(j=0; j < MAX_NCOLS; j++) {
-            new_map->array[i][j] = NULL;
+    new_map->block = NULL;
+    new_map->cells = NULL;
+    new_map->compact = compact;
+    new_map->symbols = NULL;
+    new_map->stride = ncols;
+    new_map->mapping = NULL;
+    new_map->mapping_size = 0;
+    new_map->visited = NULL;
+    new_map->nbmask = NULL;
+    new_map->input_idx = MAP_NOCELL;
+    new_map->output_idx = MAP_NOCELL;
+    new_map->field = NULL;
+    new_map->field_src = NULL;
+    new_map->field_nsrc = 0;
+    new_map->field_valid = FALSE;
+    new_map->comp = NULL;
+    new_map->comp_valid = FALSE;
+    new_map->listener = NULL;
+    new_map->listener_data = NULL;
+    new_map->owner.changed = _map_pointChanged;
+    new_map->owner.data = new_map;
+
+    n = (size_t)nrows * ncols;
+    if(mapped == FALSE) {
+        new_map->nbmask = (uint8_t*) calloc(n ? n : 1, 1);
+        if(!new_map->nbmask) {
+            map_free(new_map);
+            return NULL;
+        }
+    }
+
+    if(compact == FALSE) {
+        /* un unico bloque contiguo con exactamente nrows*ncols celdas */
+        new_map->cells = (Point**) calloc(n ? n : 1, sizeof(Point*));
+        if(!new_map->cells) {
+            map_free(new_map);
+            return NULL;
+        }
+    }
+    else {
+        /* un byte por simbolo y un bit por visitado */
+        new_map->visited = (uint64_t*) calloc(n / 64 + 1, sizeof(uint64_t));
+        if(mapped == FALSE) {
+            new_map->symbols = (uint8_t*) malloc(n ? n : 1);
+        }
+        if(!new_map->visited || (mapped == FALSE && !new_map->symbols)) {
+            map_free(new_map);
+            return NULL;
         }
     }
 
     return new_map;
 }
 
+Map * map_new (unsigned int nrows, unsigned int ncols) {
+    return _map_alloc(nrows, ncols, FALSE, FALSE);
+}
+
+Map * map_newCompact (unsigned int nrows, unsigned int ncols) {
+    Map *mp;
+
+    mp = _map_alloc(nrows, ncols, TRUE, FALSE);
+    if(mp) {
+        memset(mp->symbols, SPACE, (size_t)nrows * ncols);
+        _map_buildMasks(mp);
+    }
+
+    return mp;
+}
+
+Bool map_isCompact (const Map *mp) {
+    if(!mp) {
+        return FALSE;
+    }
+
+    return mp->compact;
+}
+
 void map_free (Map *g) {
-    int i, j;
+    size_t i, n;
 
     if(!g){
         return;
     }
 
-    for(i=0; i < MAX_NROWS; i++) {
-        for(j=0; j < MAX_NCOLS; j++) {
-            point_free(g->array[i][j]);
-            g->array[i][j]=NULL;
+    /* los puntos del bloque se liberan de una vez, solo se liberan
+       uno a uno los insertados desde fuera */
+    if(g->cells) {
+        n = (size_t)g->nrows * g->ncols;
+        for(i=0; i < n; i++) {
+            if(!g->block || g->cells[i] != point_getBlockPoint(g->block, i)) {
+                point_free(g->cells[i]);
+            }
         }
     }
 
+    point_freeBlock(g->block);
+    free(g->cells);
+    if(g->mapping) {
+        munmap(g->mapping, g->mapping_size);
+    }
+    else {
+        free(g->symbols);
+    }
+    free(g->visited);
+    free(g->nbmask);
+    free(g->field);
+    free(g->field_src);
+    free(g->comp);
+    free(g);
+}
 
+/* Simbolo de la celda i en cualquiera de los dos modos */
+static char _map_symbolAt (const Map *mp, size_t i) {
+    if(mp->compact == TRUE) {
+        if(mp->stride == mp->ncols) {
+            return (char) mp->symbols[i];
+        }
+        return (char) MAP_SYMBOL(mp, i % mp->ncols, i / mp->ncols);
+    }
 
-    free(g);
+    return point_getSymbol(mp->cells[i]);
+}
+
+/* Indica si se puede pasar por la celda i */
+/* Un simbolo es transitable si no es muro; en los mapas proyectados de 
+   fichero, que no siempre se han recorrido al abrirlos, solo lo son los 
+   simbolos del laberinto (un salto de linea descolocado es muro) */
+static Bool _map_symbolOpen (const Map *mp, char c) {
+    if(mp->mapping) {
+        return (c == SPACE || c == INPUT || c == OUTPUT) ? TRUE : FALSE;
+    }
+
+    return (c != BARRIER && c != ERRORCHAR) ? TRUE : FALSE;
+}
+
+static Bool _map_isOpen (const Map *mp, size_t i) {
+    if(mp->compact == FALSE && !mp->cells[i]) {
+        return FALSE;
+    }
+
+    return _map_symbolOpen(mp, _map_symbolAt(mp, i));
+}
+
+/* Calcula la mascara de vecinos transitables de la celda i */
+static uint8_t _map_computeMask (const Map *mp, size_t i) {
+    size_t x = i % mp->ncols, y = i / mp->ncols;
+    const uint8_t *c;
+    uint8_t m = 0;
+
+    //en modo compacto se leen directamente los simbolos vecinos
+    if(mp->compact == TRUE) {
+#define OPEN(s) (_map_symbolOpen(mp, (char)(s)) == TRUE)
+        c = &MAP_SYMBOL(mp, x, y);
+        if(x + 1 < mp->ncols && OPEN(c[1])) {
+            m |= MAP_MASK(RIGHT);
+        }
+        if(y > 0 && OPEN(c[-(long)mp->stride])) {
+            m |= MAP_MASK(UP);
+        }
+        if(x > 0 && OPEN(c[-1])) {
+            m |= MAP_MASK(LEFT);
+        }
+        if(y + 1 < mp->nrows && OPEN(c[mp->stride])) {
+            m |= MAP_MASK(DOWN);
+        }
+#undef OPEN
+        return m;
+    }
+
+    if(x + 1 < mp->ncols && _map_isOpen(mp, i + 1) == TRUE) {
+        m |= MAP_MASK(RIGHT);
+    }
+    if(y > 0 && _map_isOpen(mp, i - mp->ncols) == TRUE) {
+        m |= MAP_MASK(UP);
+    }
+    if(x > 0 && _map_isOpen(mp, i - 1) == TRUE) {
+        m |= MAP_MASK(LEFT);
+    }
+    if(y + 1 < mp->nrows && _map_isOpen(mp, i + mp->ncols) == TRUE) {
+        m |= MAP_MASK(DOWN);
+    }
+
+    return m;
+}
+
+/* Calcula las mascaras de todas las celdas, una pasada por filas */
+static void _map_buildMasks (Map *mp) {
+    size_t i, y, n = (size_t)mp->nrows * mp->ncols;
+    const char *rows;
+
+    if(mp->compact == TRUE) {
+        rows = (const char*) mp->symbols;
+        for(y=0; y < mp->nrows; y++) {
+            _map_maskRow(mp, y, y > 0 ? rows + (y - 1) * mp->stride : NULL, rows + y * mp->stride,
+                         y + 1 < mp->nrows ? rows + (y + 1) * mp->stride : NULL);
+        }
+        return;
+    }
+
+    for(i=0; i < n; i++) {
+        mp->nbmask[i] = _map_computeMask(mp, i);
+    }
+}
+
+/* Tras cambiar la celda i solo cambian las mascaras de sus cuatro vecinos */
+static void _map_updateMasks (Map *mp, size_t i) {
+    size_t x = i % mp->ncols, y = i / mp->ncols;
+
+    if(!mp->nbmask) {
+        return;
+    }
+
+    if(x + 1 < mp->ncols) {
+        mp->nbmask[i + 1] = _map_computeMask(mp, i + 1);
+    }
+    if(y > 0) {
+        mp->nbmask[i - mp->ncols] = _map_computeMask(mp, i - mp->ncols);
+    }
+    if(x > 0) {
+        mp->nbmask[i - 1] = _map_computeMask(mp, i - 1);
+    }
+    if(y + 1 < mp->nrows) {
+        mp->nbmask[i + mp->ncols] = _map_computeMask(mp, i + mp->ncols);
+    }
+}
+
+static void _map_componentsChanged (Map *mp, size_t i);
+
+/* Todo lo que depende del simbolo de la celda i tras cambiarlo: mascaras, 
+   campo de distancias y el planificador que escucha los cambios */
+static void _map_cellChanged (Map *mp, size_t i) {
+    _map_updateMasks(mp, i);
+    mp->field_valid = FALSE;
+    _map_componentsChanged(mp, i);
+    if(mp->listener) {
+        mp->listener(mp->listener_data, mp, (uint32_t) i);
+    }
+}
+
+/* Mascara de vecinos de la celda i: los mapas proyectados de fichero no 
+   guardan mascaras y la calculan al vuelo */
+static uint8_t _map_mask (const Map *mp, size_t i) {
+    if(mp->nbmask) {
+        return mp->nbmask[i];
+    }
+
+    return _map_computeMask(mp, i);
+}
+
+/* Desplazamiento del indice de celda hacia cada Position */
+static long _map_offset (const Map *mp, int pos) {
+    switch(pos) {
+        case RIGHT:
+            return 1;
+        case UP:
+            return -(long)mp->ncols;
+        case LEFT:
+            return -1;
+        case DOWN:
+            return (long)mp->ncols;
+        default:
+            return 0;
+    }
+}
+
+/* Guarda en nb los vecinos transitables de la celda i en el orden 
+   RIGHT, UP, LEFT, DOWN y devuelve cuantos hay */
+static int _map_neighbours (const Map *mp, size_t i, size_t nb[4]) {
+    uint8_t m = _map_mask(mp, i);
+    int n = 0;
+
+    if(m & MAP_MASK(RIGHT)) {
+        nb[n++] = i + 1;
+    }
+    if(m & MAP_MASK(UP)) {
+        nb[n++] = i - mp->ncols;
+    }
+    if(m & MAP_MASK(LEFT)) {
+        nb[n++] = i - 1;
+    }
+    if(m & MAP_MASK(DOWN)) {
+        nb[n++] = i + mp->ncols;
+    }
+
+    return n;
 }
 
 Point *map_insertPoint (Map *mp, Point *p) {
@@ -58,19 +391,26 @@ Point *map_insertPoint (Map *mp, Point *p) {
         return NULL;
     }
 
-    x = point_getCoordinateX(p);
-    y = point_getCoordinateY(p);
-    if(x == __INT_MAX__ || y == __INT_MAX__) {
+    x = MAP_POINT_X(p);
+    y = MAP_POINT_Y(p);
+    if(x == __INT_MAX__ || y == __INT_MAX__ || x >= mp->ncols || y >= mp->nrows || mp->mapping) {
         return NULL;
     }
 
-    //introducir el punto
-    mp->array[y][x] = p;
-    if(!mp->array) {
-        return NULL;
+    //en modo compacto solo se copia el simbolo, el punto sigue siendo del llamante
+    if(mp->compact == TRUE) {
+        MAP_SYMBOL(mp, x, y) = (uint8_t) MAP_POINT_SYMBOL(p);
+        _map_cellChanged(mp, MAP_INDEX(mp, x, y));
+        return p;
     }
 
-    return mp->array[y][x];
+    //introducir el punto, que pasa a avisar al mapa de sus cambios de simbolo
+    point_setOwner(mp->cells[MAP_INDEX(mp, x, y)], NULL);
+    mp->cells[MAP_INDEX(mp, x, y)] = p;
+    point_setOwner(p, &mp->owner);
+    _map_cellChanged(mp, MAP_INDEX(mp, x, y));
+
+    return p;
 }
 
 int map_getNcols (const Map *mp) {
@@ -114,13 +454,13 @@ Point *map_getPoint (const Map *mp, const Point *p) {
         return NULL;
     }
 
-    x = point_getCoordinateX(p);
-    y = point_getCoordinateY(p);
-    if(x == __INT_MAX__ || y == __INT_MAX__) {
+    x = MAP_POINT_X(p);
+    y = MAP_POINT_Y(p);
+    if(x == __INT_MAX__ || y == __INT_MAX__ || x >= mp->ncols || y >= mp->nrows || mp->compact == TRUE) {
         return NULL;
     }
 
-    return mp->array[y][x];
+    return mp->cells[MAP_INDEX(mp, x, y)];
 }
 
 Point *map_getNeighboor (const Map *mp, const Point *p, Position pos) {
@@ -130,8 +470,8 @@ Point *map_getNeighboor (const Map *mp, const Point *p, Position pos) {
         return NULL;
     }
 
-    x = point_getCoordinateX(p);
-    y = point_getCoordinateY(p);
+    x = MAP_POINT_X(p);
+    y = MAP_POINT_Y(p);
     if(x == __INT_MAX__ || y == __INT_MAX__) {
         return NULL;
     }
@@ -153,29 +493,191 @@ Point *map_getNeighboor (const Map *mp, const Point *p, Position pos) {
             break;
     }
 
-    if(y > map_getNrows(mp) || x > map_getNcols(mp)) {
+    if(x < 0 || y < 0 || x >= mp->ncols || y >= mp->nrows || mp->compact == TRUE) {
         return NULL;
     }
 
-    return mp->array[y][x];
+    return mp->cells[MAP_INDEX(mp, x, y)];
+}
+
+/* Indice de la celda con las coordenadas de p, MAP_NOCELL si no esta en el mapa */
+static size_t _map_pointIndex (const Map *mp, const Point *p) {
+    int x, y;
+
+    x = MAP_POINT_X(p);
+    y = MAP_POINT_Y(p);
+    if(x == __INT_MAX__ || y == __INT_MAX__ || x >= mp->ncols || y >= mp->nrows) {
+        return MAP_NOCELL;
+    }
+
+    return MAP_INDEX(mp, x, y);
+}
+
+/* Aviso de point_setSymbol sobre un punto del mapa data */
+static void _map_pointChanged (void *data, const Point *p) {
+    Map *mp = (Map*) data;
+    size_t i = _map_pointIndex(mp, p);
+
+    if(i != MAP_NOCELL && mp->cells[i] == p) {
+        _map_cellChanged(mp, i);
+    }
 }
 
 Status map_setInput (Map *mp, Point *p) {
-    if(!mp || !p) {
+    size_t i;
+
+    if(!mp || !p || (i = _map_pointIndex(mp, p)) == MAP_NOCELL) {
         return ERROR;
     }
 
-    mp->input = p;
+    mp->input = mp->compact == TRUE ? NULL : p;
+    mp->input_idx = i;
 
     return OK;
 }
 
 Status map_setOutput (Map *mp, Point *p) {
-    if(!mp || !p) {
+    size_t i;
+
+    if(!mp || !p || (i = _map_pointIndex(mp, p)) == MAP_NOCELL) {
+        return ERROR;
+    }
+
+    mp->output = mp->compact == TRUE ? NULL : p;
+    //el campo calculado desde la salida deja de valer si la salida cambia
+    if(mp->output_idx != i && !mp->field_src) {
+        mp->field_valid = FALSE;
+    }
+    mp->output_idx = i;
+
+    return OK;
+}
+
+//Vistas de celdas (validas en ambos modos)
+
+/* Rellena la vista de la celda i */
+static void _map_fillCell (const Map *mp, size_t i, MapCell *cell) {
+    cell->x = (int)(i % mp->ncols);
+    cell->y = (int)(i / mp->ncols);
+    cell->symbol = _map_symbolAt(mp, i);
+    if(mp->compact == TRUE) {
+        cell->visited = BIT_GET(mp->visited, i) ? TRUE : FALSE;
+    }
+    else {
+        cell->visited = point_getVisited(mp->cells[i]);
+    }
+}
+
+Status map_getCell (const Map *mp, int x, int y, MapCell *cell) {
+    if(!mp || !cell || x < 0 || y < 0 || x >= mp->ncols || y >= mp->nrows) {
+        return ERROR;
+    }
+
+    if(mp->compact == FALSE && !mp->cells[MAP_INDEX(mp, x, y)]) {
+        return ERROR;
+    }
+
+    _map_fillCell(mp, MAP_INDEX(mp, x, y), cell);
+
+    return OK;
+}
+
+Status map_getCellNeighboor (const Map *mp, const MapCell *cell, Position pos, MapCell *neighboor) {
+    int x, y;
+
+    if(!mp || !cell || !neighboor) {
+        return ERROR;
+    }
+
+    x = cell->x;
+    y = cell->y;
+    switch(pos) {
+        case RIGHT:
+            x ++;
+            break;
+        case LEFT:
+            x --;
+            break;
+        case UP:
+            y --;
+            break;
+        case DOWN:
+            y ++;
+            break;
+        case STAY:
+            break;
+        default:
+            return ERROR;
+    }
+
+    return map_getCell(mp, x, y, neighboor);
+}
+
+Status map_getInputCell (const Map *mp, MapCell *cell) {
+    if(!mp || !cell || mp->input_idx == MAP_NOCELL) {
+        return ERROR;
+    }
+
+    _map_fillCell(mp, mp->input_idx, cell);
+
+    return OK;
+}
+
+Status map_getOutputCell (const Map *mp, MapCell *cell) {
+    if(!mp || !cell || mp->output_idx == MAP_NOCELL) {
+        return ERROR;
+    }
+
+    _map_fillCell(mp, mp->output_idx, cell);
+
+    return OK;
+}
+
+Status map_setCellSymbol (Map *mp, int x, int y, char symbol) {
+    if(!mp || x < 0 || y < 0 || x >= mp->ncols || y >= mp->nrows || symbol == ERRORCHAR || mp->mapping) {
+        return ERROR;
+    }
+
+    //los puntos del mapa avisan ellos mismos del cambio a _map_pointChanged
+    if(mp->compact == FALSE) {
+        return point_setSymbol(mp->cells[MAP_INDEX(mp, x, y)], symbol);
+    }
+
+    MAP_SYMBOL(mp, x, y) = (uint8_t) symbol;
+    _map_cellChanged(mp, MAP_INDEX(mp, x, y));
+
+    return OK;
+}
+
+Status map_setCellListener (Map *mp, P_map_cellChanged listener, void *data) {
+    if(!mp || (listener && mp->listener)) {
+        return ERROR;
+    }
+
+    mp->listener = listener;
+    mp->listener_data = listener ? data : NULL;
+
+    return OK;
+}
+
+Status map_setCellVisited (Map *mp, int x, int y, Bool visited) {
+    size_t i;
+
+    if(!mp || x < 0 || y < 0 || x >= mp->ncols || y >= mp->nrows) {
         return ERROR;
     }
 
-    mp->output = p;
+    i = MAP_INDEX(mp, x, y);
+    if(mp->compact == FALSE) {
+        return point_setVisited(mp->cells[i], visited);
+    }
+
+    if(visited == TRUE) {
+        BIT_SET(mp->visited, i);
+    }
+    else {
+        BIT_CLEAR(mp->visited, i);
+    }
 
     return OK;
 }
@@ -184,7 +686,7 @@ Status map_setOutput (Map *mp, Point *p) {
 
 Bool map_equal (const void *_mp1, const void *_mp2) {
     Map *m1, *m2;
-    int i, j;
+    size_t i, n;
 
     if(!_mp1 || !_mp2) {
         return FALSE;
@@ -201,19 +703,19 @@ Bool map_equal (const void *_mp1, const void *_mp2) {
         return FALSE;
     }
 
-    for(i=0; i<m1->nrows; i++) {
-        for(j=0; j<m1->ncols; j++) {
-            if(point_equal(m1->array[i][j], m2->array[i][j]) == FALSE) {
-                return FALSE;
-            }
+    //se comparan los simbolos celda a celda, sea cual sea el modo de cada mapa
+    n = (size_t)m1->nrows * m1->ncols;
+    for(i=0; i<n; i++) {
+        if(_map_symbolAt(m1, i) != _map_symbolAt(m2, i)) {
+            return FALSE;
         }
     }
 
-    if(m1->input != m2->input) {
+    if(m1->input_idx != m2->input_idx) {
         return FALSE;
     }
 
-    if(m1->output != m2->output) {
+    if(m1->output_idx != m2->output_idx) {
         return FALSE;
     }
 
@@ -221,7 +723,9 @@ Bool map_equal (const void *_mp1, const void *_mp2) {
 }
 
 int map_print (FILE *pf, Map *mp) {
-    int i, j, nchars=0, aux;
+    int nchars=0, aux;
+    size_t i, n;
+    MapCell cell;
 
     if(!pf || !mp) {
         return -1;
@@ -231,72 +735,1759 @@ int map_print (FILE *pf, Map *mp) {
     fprintf(pf, "%d, %d\n", mp->nrows, mp->ncols);
 
     //print the points
-    for(i=0; i<mp->nrows; i++) {
-        for(j=0; j<mp->ncols; j++){
-            if((aux = point_print(pf, mp->array[i][j]) )== -1) {
-                return -1;
-            }
-            nchars += aux;
+    n = (size_t)mp->nrows * mp->ncols;
+    for(i=0; i<n; i++) {
+        if(mp->compact == TRUE) {
+            _map_fillCell(mp, i, &cell);
+            aux = fprintf(pf, "[(%d, %d): %c]", cell.x, cell.y, cell.symbol);
+        }
+        else {
+            aux = point_print(pf, mp->cells[i]);
+        }
+
+        if(aux < 0) {
+            return -1;
         }
+        nchars += aux;
     }
     fprintf(pf, "\n");
     return nchars;
 }
 
-Map * map_readFromFile (FILE *pf) {
-    int nrows, ncols, x, y;
-    char c;
-    Map *new_map = NULL;
-
-    if(!pf) {
-        return NULL;
+/* Vuelca el buffer en pf con un unico fwrite */
+static Status _map_flush (FILE *pf, const char *buf, size_t *used, size_t *total) {
+    if(*used > 0 && fwrite(buf, 1, *used, pf) != *used) {
+        return ERROR;
     }
+    *total += *used;
+    *used = 0;
+    return OK;
+}
 
-    if(fscanf(pf, "%d %d", &nrows, &ncols)!=2) {
-        return NULL;
+int map_printBuffered (FILE *pf, const Map *mp, char *buf, size_t size, Bool raw) {
+    size_t i, x, y, n, used = 0, total = 0, chunk;
+    const uint8_t *row;
+
+    if(!pf || !mp || !buf || size < POINT_RENDER_MAX) {
+        return -1;
     }
 
+    n = (size_t)mp->nrows * mp->ncols;
+    if(mp->compact == FALSE) {
+        for(i=0; i < n; i++) {
+            if(!mp->cells[i]) {
+                return -1;
+            }
+        }
+    }
 
-    //crear mapa
-    new_map = map_new(nrows, ncols);
-    if(!new_map) {
-        return NULL;
+    //cabecera: "filas columnas" en modo raw, "filas, columnas" si no
+    used += point_renderInt(buf + used, mp->nrows);
+    if(raw == FALSE) {
+        buf[used++] = ',';
     }
-    
-    //leer de fichero e introducir nuevos puntos
-    for(y=0; y<nrows; y++ ) {
-        for(x=0; x<ncols; x++) {
-            c=fgetc(pf);
-            if(!c) {
-                map_free(new_map);
-                return NULL;
-            }
+    buf[used++] = ' ';
+    used += point_renderInt(buf + used, mp->ncols);
+    buf[used++] = '\n';
 
-            if(c == '\n') {
-                x--;
+    if(raw == FALSE) {
+        for(i=0; i < n; i++) {
+            if(size - used < POINT_RENDER_MAX && _map_flush(pf, buf, &used, &total) == ERROR) {
+                return -1;
             }
-            else {
-                if(!map_insertPoint(new_map, point_new(x, y, c))) {
-                    map_free(new_map);
-                    return NULL;
-                }
-
-                if(c==INPUT) {
-                    if(map_setInput(new_map, new_map->array[y][x])==ERROR || map_getInput(new_map)==NULL){
-                        map_free(new_map);
-                        return NULL;
+            used += point_renderCoords(buf + used, (int)(i % mp->ncols), (int)(i / mp->ncols), _map_symbolAt(mp, i));
+        }
+        buf[used++] = '\n';
+    }
+    else {
+        for(y=0; y < mp->nrows; y++) {
+            if(mp->compact == TRUE) {
+                //las filas del plano de simbolos se copian por trozos
+                row = mp->symbols + y * mp->stride;
+                for(x=0; x < mp->ncols; x += chunk) {
+                    if(used == size && _map_flush(pf, buf, &used, &total) == ERROR) {
+                        return -1;
+                    }
+                    chunk = mp->ncols - x;
+                    if(chunk > size - used) {
+                        chunk = size - used;
                     }
+                    memcpy(buf + used, row + x, chunk);
+                    used += chunk;
                 }
-
-                if(c==OUTPUT) {
-                    if(map_setOutput(new_map, new_map->array[y][x])==ERROR || map_getOutput(new_map)==NULL){
-                        map_free(new_map);
-                        return NULL;
+            }
+            else {
+                for(x=0; x < mp->ncols; x++) {
+                    if(used == size && _map_flush(pf, buf, &used, &total) == ERROR) {
+                        return -1;
                     }
+                    buf[used++] = point_getSymbol(mp->cells[y * mp->ncols + x]);
                 }
             }
+            if(used == size && _map_flush(pf, buf, &used, &total) == ERROR) {
+                return -1;
+            }
+            buf[used++] = '\n';
         }
     }
 
-    return new_map;
+    if(_map_flush(pf, buf, &used, &total) == ERROR) {
+        return -1;
+    }
+
+    return (int) total;
+}
+
+int map_printPath (FILE *pf, const Map *mp, const uint32_t *path, size_t len, char *buf, size_t size) {
+    size_t i, n, used = 0, total = 0;
+
+    if(!pf || !mp || (!path && len > 0) || !buf || size < POINT_RENDER_MAX) {
+        return -1;
+    }
+
+    n = (size_t)mp->nrows * mp->ncols;
+    for(i=0; i < len; i++) {
+        if(path[i] >= n || (mp->compact == FALSE && !mp->cells[path[i]])) {
+            return -1;
+        }
+        if(size - used < POINT_RENDER_MAX && _map_flush(pf, buf, &used, &total) == ERROR) {
+            return -1;
+        }
+        used += point_renderCoords(buf + used, (int)(path[i] % mp->ncols), (int)(path[i] / mp->ncols), _map_symbolAt(mp, path[i]));
+    }
+
+    if(_map_flush(pf, buf, &used, &total) == ERROR) {
+        return -1;
+    }
+
+    return (int) total;
+}
+
+/* Lee todo lo que queda de pf en un unico buffer */
+static char * _map_slurp (FILE *pf, size_t *size) {
+    struct stat st;
+    size_t cap = 1 << 16, n = 0, r;
+    long pos;
+    char *buf, *aux;
+
+    //si es un fichero normal se reserva de una vez lo que falta por leer
+    pos = ftell(pf);
+    if(pos >= 0 && fstat(fileno(pf), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > pos) {
+        cap = (size_t)(st.st_size - pos) + 1;
+    }
+
+    buf = (char*) malloc(cap);
+    if(!buf) {
+        return NULL;
+    }
+
+    while((r = fread(buf + n, 1, cap - n, pf)) > 0) {
+        n += r;
+        if(n == cap) {
+            aux = (char*) realloc(buf, cap * 2);
+            if(!aux) {
+                free(buf);
+                return NULL;
+            }
+            buf = aux;
+            cap *= 2;
+        }
+    }
+
+    if(ferror(pf)) {
+        free(buf);
+        return NULL;
+    }
+
+    *size = n;
+
+    return buf;
+}
+
+/* Lee un entero no negativo de la cabecera a partir de buf[*pos] */
+static Status _map_parseInt (const char *buf, size_t size, size_t *pos, int *value) {
+    long v = 0;
+    size_t i = *pos;
+
+    if(i >= size || buf[i] < '0' || buf[i] > '9') {
+        return ERROR;
+    }
+
+    for(; i < size && buf[i] >= '0' && buf[i] <= '9'; i++) {
+        v = v * 10 + (buf[i] - '0');
+        if(v > __INT_MAX__) {
+            return ERROR;
+        }
+    }
+
+    *pos = i;
+    *value = (int) v;
+
+    return OK;
+}
+
+/* Lee la cabecera "nrows ncols" de la primera linea con contenido y deja
+   *pos al principio de la linea siguiente; *line es la linea de la cabecera,
+   o la posicion del error junto con *col */
+static Status _map_parseHeader (const char *buf, size_t size, size_t *pos, int *nrows, int *ncols, int *line, int *col) {
+    const char *row = buf;
+    size_t i = *pos;
+
+    *line = 1;
+    while(i < size && (buf[i] == ' ' || buf[i] == '\t' || buf[i] == '\r' || buf[i] == '\n')) {
+        if(buf[i] == '\n') {
+            (*line)++;
+            row = buf + i + 1;
+        }
+        i++;
+    }
+
+    if(_map_parseInt(buf, size, &i, nrows) == ERROR) {
+        *col = (int)(buf + i - row) + 1;
+        return ERROR;
+    }
+    while(i < size && (buf[i] == ' ' || buf[i] == '\t')) {
+        i++;
+    }
+    if(_map_parseInt(buf, size, &i, ncols) == ERROR) {
+        *col = (int)(buf + i - row) + 1;
+        return ERROR;
+    }
+    while(i < size && (buf[i] == ' ' || buf[i] == '\t' || buf[i] == '\r')) {
+        i++;
+    }
+    if(i < size && buf[i] != '\n') {
+        *col = (int)(buf + i - row) + 1;
+        return ERROR;
+    }
+
+    *pos = i + 1;
+
+    return OK;
+}
+
+/* Calcula las mascaras de vecinos de la fila y a partir del texto de las
+   filas y-1 (prev), y (cur) e y+1 (next); prev y next pueden ser NULL */
+static void _map_maskRow (Map *mp, size_t y, const char *prev, const char *cur, const char *next) {
+    uint8_t *restrict mask = mp->nbmask + y * mp->ncols;
+    const uint8_t up = prev ? MAP_MASK(UP) : 0, down = next ? MAP_MASK(DOWN) : 0;
+    size_t x, n = mp->ncols;
+
+    if(n == 0) {
+        return;
+    }
+    if(!prev) {
+        prev = cur;
+    }
+    if(!next) {
+        next = cur;
+    }
+
+    //sin saltos dentro del bucle para que el compilador lo pueda vectorizar
+#define OPEN(c) (uint8_t)(0 - (uint8_t)((c) != BARRIER && (c) != ERRORCHAR))
+    mask[0] = (n > 1 ? OPEN(cur[1]) & MAP_MASK(RIGHT) : 0) | (OPEN(prev[0]) & up) | (OPEN(next[0]) & down);
+    for(x=1; x + 1 < n; x++) {
+        mask[x] = (OPEN(cur[x + 1]) & MAP_MASK(RIGHT)) | (OPEN(prev[x]) & up)
+                  | (OPEN(cur[x - 1]) & MAP_MASK(LEFT)) | (OPEN(next[x]) & down);
+    }
+    if(n > 1) {
+        mask[n - 1] = (OPEN(prev[n - 1]) & up) | (OPEN(cur[n - 2]) & MAP_MASK(LEFT)) | (OPEN(next[n - 1]) & down);
+    }
+#undef OPEN
+}
+
+/* Guarda la posicion (1-based) de un error de lectura */
+static Map * _map_loadError (Map *mp, char *buf, int line, int col, int *err_line, int *err_col) {
+    if(err_line) {
+        *err_line = line;
+    }
+    if(err_col) {
+        *err_col = col;
+    }
+
+    map_free(mp);
+    free(buf);
+
+    return NULL;
+}
+
+Map * map_load (FILE *pf, Bool compact, int *err_line, int *err_col) {
+    int nrows, ncols, y, line;
+    size_t size, pos, len, i;
+    char *buf;
+    const char *row, *end, *prev = NULL, *cur = NULL, *c;
+    Map *new_map = NULL;
+
+    if(err_line) {
+        *err_line = 0;
+    }
+    if(err_col) {
+        *err_col = 0;
+    }
+
+    if(!pf) {
+        return NULL;
+    }
+
+    buf = _map_slurp(pf, &size);
+    if(!buf) {
+        return NULL;
+    }
+
+    //cabecera: filas y columnas
+    pos = 0;
+    if(_map_parseHeader(buf, size, &pos, &nrows, &ncols, &line, &y) == ERROR) {
+        return _map_loadError(NULL, buf, line, y, err_line, err_col);
+    }
+
+    //crear mapa
+    new_map = _map_alloc(nrows, ncols, compact, FALSE);
+    if(!new_map) {
+        free(buf);
+        return NULL;
+    }
+
+    //reservar todos los puntos del mapa de una vez
+    if(compact == FALSE && nrows > 0 && ncols > 0) {
+        new_map->block = point_newBlock((size_t)nrows * ncols);
+        if(!new_map->block) {
+            free(buf);
+            map_free(new_map);
+            return NULL;
+        }
+    }
+
+    //cada fila es una linea de exactamente ncols simbolos, con '\n' o "\r\n"
+    for(y=0; y < nrows; y++) {
+        if(pos >= size) {
+            return _map_loadError(new_map, buf, line + y + 1, 1, err_line, err_col);
+        }
+
+        row = buf + pos;
+        end = memchr(row, '\n', size - pos);
+        if(!end) {
+            end = buf + size;
+        }
+        len = (size_t)(end - row);
+        if(len > 0 && row[len - 1] == '\r') {
+            len--;
+        }
+
+        if(len != (size_t)ncols) {
+            return _map_loadError(new_map, buf, line + y + 1, (int)(len < (size_t)ncols ? len : (size_t)ncols) + 1, err_line, err_col);
+        }
+        if((c = memchr(row, ERRORCHAR, len)) != NULL) {
+            return _map_loadError(new_map, buf, line + y + 1, (int)(c - row) + 1, err_line, err_col);
+        }
+
+        i = MAP_INDEX(new_map, 0, y);
+        if(compact == TRUE) {
+            memcpy(new_map->symbols + i, row, len);
+        }
+        else {
+            point_fillBlockRow(point_getBlockPoint(new_map->block, i), y, row, len, &new_map->owner);
+            for(; i < MAP_INDEX(new_map, 0, y + 1); i++) {
+                new_map->cells[i] = point_getBlockPoint(new_map->block, i);
+            }
+        }
+
+        //entrada y salida: se queda la ultima que aparece
+        for(c = row; (c = memchr(c, INPUT, len - (size_t)(c - row))) != NULL; c++) {
+            new_map->input_idx = MAP_INDEX(new_map, c - row, y);
+        }
+        for(c = row; (c = memchr(c, OUTPUT, len - (size_t)(c - row))) != NULL; c++) {
+            new_map->output_idx = MAP_INDEX(new_map, c - row, y);
+        }
+
+        //la mascara de la fila anterior ya tiene todos sus vecinos
+        if(y > 0) {
+            _map_maskRow(new_map, y - 1, prev, cur, row);
+        }
+        prev = cur;
+        cur = row;
+
+        pos = (size_t)(end - buf) + 1;
+    }
+
+    if(nrows > 0) {
+        _map_maskRow(new_map, nrows - 1, prev, cur, NULL);
+    }
+
+    if(compact == FALSE) {
+        if(new_map->input_idx != MAP_NOCELL) {
+            new_map->input = new_map->cells[new_map->input_idx];
+        }
+        if(new_map->output_idx != MAP_NOCELL) {
+            new_map->output = new_map->cells[new_map->output_idx];
+        }
+    }
+
+    free(buf);
+    //sin memoria para las componentes el mapa sigue valiendo: se reintenta al consultarlas
+    map_labelComponents(new_map);
+
+    return new_map;
+}
+
+Map * map_readFromFile (FILE *pf) {
+    return map_load(pf, FALSE, NULL, NULL);
+}
+
+Map * map_readFromFileCompact (FILE *pf) {
+    return map_load(pf, TRUE, NULL, NULL);
+}
+
+Map * map_mmapFile (const char *filename, Bool find_ends, int *err_line, int *err_col) {
+    int fd, nrows, ncols, line, col, y;
+    struct stat st;
+    size_t pos, data, last;
+    char *base;
+    const char *row, *c, *end;
+    Map *new_map;
+
+    if(err_line) {
+        *err_line = 0;
+    }
+    if(err_col) {
+        *err_col = 0;
+    }
+
+    if(!filename) {
+        return NULL;
+    }
+
+    fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+    if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    base = (char*) mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return NULL;
+    }
+
+    pos = 0;
+    if(_map_parseHeader(base, (size_t)st.st_size, &pos, &nrows, &ncols, &line, &col) == ERROR) {
+        munmap(base, (size_t)st.st_size);
+        return _map_loadError(NULL, NULL, line, col, err_line, err_col);
+    }
+
+    new_map = _map_alloc(nrows, ncols, TRUE, TRUE);
+    if(!new_map) {
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+    new_map->mapping = base;
+    new_map->mapping_size = (size_t)st.st_size;
+    new_map->symbols = (uint8_t*) base + pos;
+
+    /* las filas estan separadas por '\n' o "\r\n": el paso entre filas se
+       deduce de la primera */
+    data = (size_t)st.st_size - pos;
+    if(nrows > 0 && ncols > 0) {
+        new_map->stride = (size_t)ncols + 1;
+        if(data > (size_t)ncols && base[pos + ncols] == '\r') {
+            new_map->stride++;
+        }
+    }
+
+    /* localizar la entrada y la salida exige leer todo el fichero, asi que
+       de paso se comprueba cada fila como en map_load: ncols simbolos 
+       sin saltos de linea ni ERRORCHAR y el mismo fin de linea que la
+       primera (la ultima puede acabar con el fichero) */
+    if(find_ends == TRUE && nrows > 0 && ncols > 0) {
+        end = base + st.st_size;
+        for(y=0; y < nrows; y++) {
+            row = (const char*) new_map->symbols + (size_t)y * new_map->stride;
+            for(c = row; c < row + ncols && c < end; c++) {
+                if(*c == '\n' || *c == '\r' || *c == ERRORCHAR) {
+                    return _map_loadError(new_map, NULL, line + y + 1, (int)(c - row) + 1, err_line, err_col);
+                }
+                if(*c == INPUT) {
+                    new_map->input_idx = MAP_INDEX(new_map, c - row, y);
+                }
+                else if(*c == OUTPUT) {
+                    new_map->output_idx = MAP_INDEX(new_map, c - row, y);
+                }
+            }
+            if(c < row + ncols) {
+                return _map_loadError(new_map, NULL, line + y + 1, (int)(c - row) + 1, err_line, err_col);
+            }
+
+            if(c == end) {
+                if(y + 1 < nrows) {
+                    return _map_loadError(new_map, NULL, line + y + 2, 1, err_line, err_col);
+                }
+            }
+            else if((*c == '\r' ? c + 1 < end && c[1] != '\n' : *c != '\n')
+                    || (y + 1 < nrows && (size_t)(*c == '\r' ? ncols + 2 : ncols + 1) != new_map->stride)) {
+                return _map_loadError(new_map, NULL, line + y + 1, ncols + 1, err_line, err_col);
+            }
+        }
+    }
+    //sin find_ends solo se comprueba el primer fin de linea y que el
+    //fichero llega a contener la ultima fila, sin recorrer el resto
+    else if(nrows > 0 && ncols > 0) {
+        if(data < (size_t)ncols) {
+            return _map_loadError(new_map, NULL, line + 1, (int)data + 1, err_line, err_col);
+        }
+        if(data > (size_t)ncols && base[pos + ncols] != '\r' && base[pos + ncols] != '\n') {
+            return _map_loadError(new_map, NULL, line + 1, ncols + 1, err_line, err_col);
+        }
+
+        last = (size_t)(nrows - 1) * new_map->stride;
+        if(data < last + (size_t)ncols) {
+            return _map_loadError(new_map, NULL, line + nrows, (int)(data > last ? data - last : 0) + 1, err_line, err_col);
+        }
+    }
+
+    return new_map;
+}
+
+//Formato binario
+
+/* Cabecera: "MAZB", version, 3 bytes a cero y cinco uint32 little-endian 
+   (nrows, ncols, entrada, salida, checksum); despues las celdas con 2 bits
+   cada una, cuatro por byte empezando por los bits bajos */
+#define MAP_BIN_MAGIC "MAZB"
+#define MAP_BIN_VERSION 1
+#define MAP_BIN_HEADER 28
+
+/* Codigos de 2 bits de los simbolos del formato binario */
+static const char _map_binSymbols[4] = { BARRIER, SPACE, INPUT, OUTPUT };
+
+static void _map_putU32 (unsigned char *b, uint32_t v) {
+    b[0] = (unsigned char) v;
+    b[1] = (unsigned char)(v >> 8);
+    b[2] = (unsigned char)(v >> 16);
+    b[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t _map_getU32 (const unsigned char *b) {
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+/* FNV-1a de 32 bits de las dimensiones, la entrada/salida y las celdas */
+static uint32_t _map_checksum (const unsigned char *header, const unsigned char *cells, size_t n) {
+    uint32_t h = 2166136261u;
+    size_t i;
+
+    for(i=8; i < 24; i++) {
+        h = (h ^ header[i]) * 16777619u;
+    }
+    for(i=0; i < n; i++) {
+        h = (h ^ cells[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+Status map_saveBinary (FILE *pf, const Map *mp) {
+    unsigned char header[MAP_BIN_HEADER], *cells;
+    size_t i, n, nbytes;
+    unsigned int code;
+    char c;
+
+    if(!pf || !mp) {
+        return ERROR;
+    }
+
+    n = (size_t)mp->nrows * mp->ncols;
+    nbytes = (n + 3) / 4;
+    cells = (unsigned char*) calloc(nbytes ? nbytes : 1, 1);
+    if(!cells) {
+        return ERROR;
+    }
+
+    for(i=0; i < n; i++) {
+        c = _map_symbolAt(mp, i);
+        for(code=0; code < 4 && _map_binSymbols[code] != c; code++);
+        if(code == 4) {
+            free(cells);
+            return ERROR;
+        }
+        cells[i >> 2] |= (unsigned char)(code << (2 * (i & 3)));
+    }
+
+    memcpy(header, MAP_BIN_MAGIC, 4);
+    header[4] = MAP_BIN_VERSION;
+    header[5] = header[6] = header[7] = 0;
+    _map_putU32(header + 8, mp->nrows);
+    _map_putU32(header + 12, mp->ncols);
+    _map_putU32(header + 16, mp->input_idx == MAP_NOCELL ? MAP_NOINDEX : (uint32_t) mp->input_idx);
+    _map_putU32(header + 20, mp->output_idx == MAP_NOCELL ? MAP_NOINDEX : (uint32_t) mp->output_idx);
+    _map_putU32(header + 24, _map_checksum(header, cells, nbytes));
+
+    if(fwrite(header, 1, MAP_BIN_HEADER, pf) != MAP_BIN_HEADER || fwrite(cells, 1, nbytes, pf) != nbytes) {
+        free(cells);
+        return ERROR;
+    }
+
+    free(cells);
+
+    return OK;
+}
+
+Map * map_loadBinary (FILE *pf, Bool compact) {
+    unsigned char header[MAP_BIN_HEADER], *cells;
+    uint32_t nrows, ncols, in, out;
+    size_t i, y, n, nbytes;
+    char *text;
+    Map *new_map;
+
+    if(!pf || fread(header, 1, MAP_BIN_HEADER, pf) != MAP_BIN_HEADER 
+       || memcmp(header, MAP_BIN_MAGIC, 4) != 0 || header[4] != MAP_BIN_VERSION) {
+        return NULL;
+    }
+
+    nrows = _map_getU32(header + 8);
+    ncols = _map_getU32(header + 12);
+    in = _map_getU32(header + 16);
+    out = _map_getU32(header + 20);
+    if(ncols && nrows >= MAP_NOINDEX / ncols) {
+        return NULL;
+    }
+
+    n = (size_t)nrows * ncols;
+    nbytes = (n + 3) / 4;
+    if((in != MAP_NOINDEX && in >= n) || (out != MAP_NOINDEX && out >= n)) {
+        return NULL;
+    }
+
+    //todas las celdas de una sola lectura
+    cells = (unsigned char*) malloc(nbytes ? nbytes : 1);
+    text = (char*) malloc(n ? n : 1);
+    if(!cells || !text || fread(cells, 1, nbytes, pf) != nbytes
+       || _map_checksum(header, cells, nbytes) != _map_getU32(header + 24)) {
+        free(cells);
+        free(text);
+        return NULL;
+    }
+
+    for(i=0; i < n; i++) {
+        text[i] = _map_binSymbols[(cells[i >> 2] >> (2 * (i & 3))) & 3];
+    }
+    free(cells);
+
+    if((in != MAP_NOINDEX && text[in] != INPUT) || (out != MAP_NOINDEX && text[out] != OUTPUT)) {
+        free(text);
+        return NULL;
+    }
+
+    new_map = _map_alloc(nrows, ncols, compact, FALSE);
+    if(!new_map || (compact == FALSE && n > 0 && !(new_map->block = point_newBlock(n)))) {
+        map_free(new_map);
+        free(text);
+        return NULL;
+    }
+
+    for(y=0; y < nrows; y++) {
+        i = MAP_INDEX(new_map, 0, y);
+        if(compact == TRUE) {
+            memcpy(new_map->symbols + i, text + i, ncols);
+        }
+        else {
+            point_fillBlockRow(point_getBlockPoint(new_map->block, i), (int) y, text + i, ncols, &new_map->owner);
+            for(; i < MAP_INDEX(new_map, 0, y + 1); i++) {
+                new_map->cells[i] = point_getBlockPoint(new_map->block, i);
+            }
+        }
+        _map_maskRow(new_map, y, y > 0 ? text + (y - 1) * ncols : NULL, text + y * ncols,
+                     y + 1 < nrows ? text + (y + 1) * ncols : NULL);
+    }
+    free(text);
+
+    if(in != MAP_NOINDEX) {
+        new_map->input_idx = in;
+        new_map->input = compact == TRUE ? NULL : new_map->cells[in];
+    }
+    if(out != MAP_NOINDEX) {
+        new_map->output_idx = out;
+        new_map->output = compact == TRUE ? NULL : new_map->cells[out];
+    }
+    map_labelComponents(new_map);
+
+    return new_map;
+}
+
+//Indices de celda
+
+uint32_t map_getCellIndex (const Map *mp, int x, int y) {
+    if(!mp || x < 0 || y < 0 || x >= mp->ncols || y >= mp->nrows) {
+        return MAP_NOINDEX;
+    }
+
+    return (uint32_t) MAP_INDEX(mp, x, y);
+}
+
+uint32_t map_getInputIndex (const Map *mp) {
+    if(!mp || mp->input_idx == MAP_NOCELL) {
+        return MAP_NOINDEX;
+    }
+
+    return (uint32_t) mp->input_idx;
+}
+
+uint32_t map_getOutputIndex (const Map *mp) {
+    if(!mp || mp->output_idx == MAP_NOCELL) {
+        return MAP_NOINDEX;
+    }
+
+    return (uint32_t) mp->output_idx;
+}
+
+Status map_getCellByIndex (const Map *mp, uint32_t i, MapCell *cell) {
+    if(!mp || !cell || i >= (size_t)mp->nrows * mp->ncols) {
+        return ERROR;
+    }
+
+    _map_fillCell(mp, i, cell);
+
+    return OK;
+}
+
+Point * map_dfs (FILE *pf, Map *mp) {
+    Stack *s;
+    Point *p, *nb;
+    size_t i, n;
+    int pos;
+    uint8_t m;
+
+    if(!pf || !mp || mp->compact == TRUE || !mp->input || !mp->output) {
+        return NULL;
+    }
+
+    //empezar con todos los puntos sin visitar
+    n = (size_t)mp->nrows * mp->ncols;
+    for(i=0; i < n; i++) {
+        point_setVisited(mp->cells[i], FALSE);
+    }
+
+    s = stack_init();
+    if(!s) {
+        return NULL;
+    }
+
+    if(stack_push(s, mp->input) == ERROR) {
+        stack_free(s);
+        return NULL;
+    }
+
+    while(stack_isEmpty(s) == FALSE) {
+        p = (Point*) stack_pop(s);
+        if(point_getVisited(p) == TRUE) {
+            continue;
+        }
+
+        point_setVisited(p, TRUE);
+        point_print(pf, p);
+
+        if(p == mp->output) {
+            stack_free(s);
+            return p;
+        }
+
+        //apilar los vecinos sin visitar que no son muro
+        i = _map_pointIndex(mp, p);
+        m = _map_mask(mp, i);
+        for(pos=RIGHT; pos < STAY; pos++) {
+            if(!(m & MAP_MASK(pos))) {
+                continue;
+            }
+            nb = mp->cells[i + _map_offset(mp, pos)];
+            if(point_getVisited(nb) == FALSE) {
+                if(stack_push(s, nb) == ERROR) {
+                    stack_free(s);
+                    return NULL;
+                }
+            }
+        }
+    }
+
+    stack_free(s);
+
+    return NULL;
+}
+
+//Espacio de trabajo para busquedas repetidas
+
+MapWorkspace * map_workspaceNew (const Map *mp) {
+    MapWorkspace *ws;
+    size_t i;
+
+    if(!mp) {
+        return NULL;
+    }
+
+    ws = (MapWorkspace*) malloc(sizeof(MapWorkspace));
+    if(!ws) {
+        return NULL;
+    }
+
+    ws->capacity = (size_t)mp->nrows * mp->ncols;
+    ws->gen = 0;
+    ws->pred = NULL;
+    ws->queue = NULL;
+    ws->cost = NULL;
+    ws->heap = NULL;
+    ws->mark2 = NULL;
+    ws->pred2 = NULL;
+    ws->cost2 = NULL;
+    ws->heap2 = NULL;
+    ws->expanded = 0;
+    ws->stack = stack_init();
+    ws->mark = (uint32_t*) calloc(ws->capacity ? ws->capacity : 1, sizeof(uint32_t));
+    if(!ws->stack || !ws->mark) {
+        map_workspaceFree(ws);
+        return NULL;
+    }
+
+    //hacer crecer la pila hasta su tamano maximo para no reservar durante las busquedas
+    for(i=0; i < ws->capacity; i++) {
+        if(stack_push(ws->stack, ws->mark + i) == ERROR) {
+            map_workspaceFree(ws);
+            return NULL;
+        }
+    }
+    while(stack_isEmpty(ws->stack) == FALSE) {
+        stack_pop(ws->stack);
+    }
+
+    return ws;
+}
+
+uint8_t map_getNeighboorMask (const Map *mp, uint32_t i) {
+    if(!mp || i >= (size_t)mp->nrows * mp->ncols) {
+        return 0;
+    }
+
+    return _map_mask(mp, i);
+}
+
+int map_getNeighboors (const Map *mp, uint32_t i, uint32_t nb[4]) {
+    uint8_t m;
+    int n = 0, pos;
+
+    if(!mp || !nb || i >= (size_t)mp->nrows * mp->ncols) {
+        return -1;
+    }
+
+    //solo se recorren los bits activos de la mascara
+    for(m = _map_mask(mp, i); m; m &= (uint8_t)(m - 1)) {
+        pos = __builtin_ctz(m);
+        nb[n++] = (uint32_t)((long)i + _map_offset(mp, pos));
+    }
+
+    return n;
+}
+
+size_t map_workspaceExpanded (const MapWorkspace *ws) {
+    if(!ws) {
+        return 0;
+    }
+
+    return ws->expanded;
+}
+
+void map_workspaceFree (MapWorkspace *ws) {
+    if(!ws) {
+        return;
+    }
+
+    if(ws->stack) {
+        stack_free(ws->stack);
+    }
+    free(ws->mark);
+    free(ws->pred);
+    free(ws->queue);
+    free(ws->cost);
+    heap_free(ws->heap);
+    free(ws->mark2);
+    free(ws->pred2);
+    free(ws->cost2);
+    heap_free(ws->heap2);
+    free(ws);
+}
+
+/* Empieza una busqueda nueva: todas las celdas pasan a no visitadas en O(1) */
+static void _map_workspaceReset (MapWorkspace *ws) {
+    ws->gen++;
+    if(ws->gen == 0) {
+        memset(ws->mark, 0, ws->capacity * sizeof(uint32_t));
+        if(ws->mark2) {
+            memset(ws->mark2, 0, ws->capacity * sizeof(uint32_t));
+        }
+        ws->gen = 1;
+    }
+    ws->expanded = 0;
+    while(stack_isEmpty(ws->stack) == FALSE) {
+        stack_pop(ws->stack);
+    }
+}
+
+Status map_dfsWorkspace (FILE *pf, const Map *mp, MapWorkspace *ws) {
+    size_t i, nb[4];
+    int k, n;
+    uint32_t *top;
+    MapCell cell;
+
+    if(!mp || !ws || (size_t)mp->nrows * mp->ncols > ws->capacity 
+       || mp->input_idx == MAP_NOCELL || mp->output_idx == MAP_NOCELL) {
+        return ERROR;
+    }
+
+    _map_workspaceReset(ws);
+
+    //cada celda se marca al apilarla, asi la pila nunca pasa de capacity elementos
+    ws->mark[mp->input_idx] = ws->gen;
+    stack_push(ws->stack, ws->mark + mp->input_idx);
+
+    while(stack_isEmpty(ws->stack) == FALSE) {
+        top = (uint32_t*) stack_pop(ws->stack);
+        i = (size_t)(top - ws->mark);
+        ws->expanded++;
+
+        if(pf) {
+            _map_fillCell(mp, i, &cell);
+            fprintf(pf, "[(%d, %d): %c]", cell.x, cell.y, cell.symbol);
+        }
+
+        if(i == mp->output_idx) {
+            return OK;
+        }
+
+        n = _map_neighbours(mp, i, nb);
+        for(k=0; k < n; k++) {
+            if(ws->mark[nb[k]] != ws->gen) {
+                ws->mark[nb[k]] = ws->gen;
+                stack_push(ws->stack, ws->mark + nb[k]);
+            }
+        }
+    }
+
+    return END;
+}
+
+/* Reserva, la primera vez que se usa, la memoria de la BFS */
+static Status _map_workspaceBfs (MapWorkspace *ws) {
+    size_t n = ws->capacity ? ws->capacity : 1;
+
+    if(!ws->pred) {
+        ws->pred = (uint32_t*) malloc(n * sizeof(uint32_t));
+    }
+    if(!ws->queue) {
+        ws->queue = (uint32_t*) malloc(n * sizeof(uint32_t));
+    }
+
+    return (ws->pred && ws->queue) ? OK : ERROR;
+}
+
+/* Reconstruye en ws->queue el camino src -> dst siguiendo ws->pred */
+static void _map_buildPath (MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len) {
+    size_t n = 1, k;
+    uint32_t i;
+
+    for(i=dst; i != src; i=ws->pred[i]) {
+        n++;
+    }
+
+    for(i=dst, k=n; k > 0; i=ws->pred[i], k--) {
+        ws->queue[k - 1] = i;
+    }
+
+    *path = ws->queue;
+    *len = n;
+}
+
+Status map_bfsBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len) {
+    size_t cap, head, tail, count, i, nb[4];
+    int k, n;
+
+    cap = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !ws || !path || !len || cap > ws->capacity || src >= cap || dst >= cap) {
+        return ERROR;
+    }
+
+    if(_map_workspaceBfs(ws) == ERROR) {
+        return ERROR;
+    }
+
+    _map_workspaceReset(ws);
+    *path = NULL;
+    *len = 0;
+
+    //en componentes distintas no hace falta buscar
+    if(_map_knownUnreachable(mp, src, dst) == TRUE) {
+        return END;
+    }
+
+    if(_map_isOpen(mp, src) == FALSE) {
+        return END;
+    }
+
+    //cola circular de capacidad fija: cada celda entra como mucho una vez
+    head = tail = count = 0;
+    ws->mark[src] = ws->gen;
+    ws->pred[src] = src;
+    ws->queue[tail] = src;
+    tail = tail + 1 == cap ? 0 : tail + 1;
+    count++;
+
+    while(count > 0) {
+        i = ws->queue[head];
+        head = head + 1 == cap ? 0 : head + 1;
+        count--;
+        ws->expanded++;
+
+        if(i == dst) {
+            _map_buildPath(ws, src, dst, path, len);
+            return OK;
+        }
+
+        n = _map_neighbours(mp, i, nb);
+        for(k=0; k < n; k++) {
+            if(ws->mark[nb[k]] != ws->gen) {
+                ws->mark[nb[k]] = ws->gen;
+                ws->pred[nb[k]] = (uint32_t) i;
+                ws->queue[tail] = (uint32_t) nb[k];
+                tail = tail + 1 == cap ? 0 : tail + 1;
+                count++;
+            }
+        }
+    }
+
+    return END;
+}
+
+Status map_bfs (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len) {
+    if(!mp) {
+        return ERROR;
+    }
+
+    return map_bfsBetween(mp, ws, map_getInputIndex(mp), map_getOutputIndex(mp), path, len);
+}
+
+/* Reserva, la primera vez que se usa, la memoria de A* (y la de la busqueda 
+   hacia atras si bidirectional es TRUE) */
+static Status _map_workspaceAstar (MapWorkspace *ws, Bool bidirectional) {
+    size_t n = ws->capacity ? ws->capacity : 1;
+
+    if(_map_workspaceBfs(ws) == ERROR) {
+        return ERROR;
+    }
+
+    if(!ws->cost) {
+        ws->cost = (uint32_t*) malloc(n * sizeof(uint32_t));
+    }
+    if(!ws->heap) {
+        ws->heap = heap_new(n);
+    }
+    if(!ws->cost || !ws->heap) {
+        return ERROR;
+    }
+
+    if(bidirectional == TRUE) {
+        if(!ws->mark2) {
+            ws->mark2 = (uint32_t*) calloc(n, sizeof(uint32_t));
+        }
+        if(!ws->pred2) {
+            ws->pred2 = (uint32_t*) malloc(n * sizeof(uint32_t));
+        }
+        if(!ws->cost2) {
+            ws->cost2 = (uint32_t*) malloc(n * sizeof(uint32_t));
+        }
+        if(!ws->heap2) {
+            ws->heap2 = heap_new(n);
+        }
+        if(!ws->mark2 || !ws->pred2 || !ws->cost2 || !ws->heap2) {
+            return ERROR;
+        }
+    }
+
+    heap_clear(ws->heap);
+    if(ws->heap2) {
+        heap_clear(ws->heap2);
+    }
+
+    return OK;
+}
+
+/* Distancia Manhattan entre las celdas a y b: en una rejilla con 4 vecinos
+   es un heuristico admisible y consistente, y mas ajustado que el euclideo */
+static uint32_t _map_heuristic (const Map *mp, size_t a, size_t b) {
+    size_t ax = a % mp->ncols, ay = a / mp->ncols;
+    size_t bx = b % mp->ncols, by = b / mp->ncols;
+
+    return (uint32_t)((ax > bx ? ax - bx : bx - ax) + (ay > by ? ay - by : by - ay));
+}
+
+/* Clave del monticulo: f en la parte alta y h en la baja, asi a igual f
+   se expande antes la celda mas cercana al destino */
+#define ASTAR_KEY(g, h) (((uint64_t)((g) + (h)) << 32) | (uint64_t)(h))
+#define ASTAR_F(key) ((uint32_t)((key) >> 32))
+
+Status map_astarBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len) {
+    size_t cap, i, nb[4];
+    uint32_t g;
+    int k, n;
+
+    cap = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !ws || !path || !len || cap > ws->capacity || src >= cap || dst >= cap) {
+        return ERROR;
+    }
+
+    if(_map_workspaceAstar(ws, FALSE) == ERROR) {
+        return ERROR;
+    }
+
+    _map_workspaceReset(ws);
+    *path = NULL;
+    *len = 0;
+
+    //en componentes distintas no hace falta buscar
+    if(_map_knownUnreachable(mp, src, dst) == TRUE) {
+        return END;
+    }
+
+    if(_map_isOpen(mp, src) == FALSE) {
+        return END;
+    }
+
+    ws->mark[src] = ws->gen;
+    ws->pred[src] = src;
+    ws->cost[src] = 0;
+    heap_push(ws->heap, src, ASTAR_KEY(0, _map_heuristic(mp, src, dst)));
+
+    //con un heuristico consistente cada celda se expande una sola vez
+    while(heap_isEmpty(ws->heap) == FALSE) {
+        i = heap_pop(ws->heap);
+        ws->expanded++;
+
+        if(i == dst) {
+            heap_clear(ws->heap);
+            _map_buildPath(ws, src, dst, path, len);
+            return OK;
+        }
+
+        g = ws->cost[i] + 1;
+        n = _map_neighbours(mp, i, nb);
+        for(k=0; k < n; k++) {
+            if(ws->mark[nb[k]] != ws->gen || g < ws->cost[nb[k]]) {
+                ws->mark[nb[k]] = ws->gen;
+                ws->pred[nb[k]] = (uint32_t) i;
+                ws->cost[nb[k]] = g;
+                heap_push(ws->heap, (uint32_t) nb[k], ASTAR_KEY(g, _map_heuristic(mp, nb[k], dst)));
+            }
+        }
+    }
+
+    return END;
+}
+
+Status map_astar (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len) {
+    if(!mp) {
+        return ERROR;
+    }
+
+    return map_astarBetween(mp, ws, map_getInputIndex(mp), map_getOutputIndex(mp), path, len);
+}
+
+/* Expande una celda de una de las dos busquedas A*: la de estado (mark, pred, 
+   cost, heap) que va hacia target. Las celdas ya alcanzadas por la otra 
+   busqueda (mark_o, cost_o) actualizan el mejor camino encontrado (best, meet) */
+static void _map_astarStep (const Map *mp, MapWorkspace *ws, uint32_t *mark, uint32_t *pred, uint32_t *cost, Heap *heap,
+                            const uint32_t *mark_o, const uint32_t *cost_o, size_t target, uint32_t *best, size_t *meet) {
+    size_t i, nb[4];
+    uint32_t g;
+    int k, n;
+
+    i = heap_pop(heap);
+    ws->expanded++;
+
+    g = cost[i] + 1;
+    n = _map_neighbours(mp, i, nb);
+    for(k=0; k < n; k++) {
+        if(mark[nb[k]] != ws->gen || g < cost[nb[k]]) {
+            mark[nb[k]] = ws->gen;
+            pred[nb[k]] = (uint32_t) i;
+            cost[nb[k]] = g;
+            heap_push(heap, (uint32_t) nb[k], ASTAR_KEY(g, _map_heuristic(mp, nb[k], target)));
+
+            if(mark_o[nb[k]] == ws->gen && g + cost_o[nb[k]] < *best) {
+                *best = g + cost_o[nb[k]];
+                *meet = nb[k];
+            }
+        }
+    }
+}
+
+Status map_astarBidirectionalBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len) {
+    size_t cap, meet, n, k;
+    uint32_t best, i;
+
+    cap = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !ws || !path || !len || cap > ws->capacity || src >= cap || dst >= cap) {
+        return ERROR;
+    }
+
+    if(_map_workspaceAstar(ws, TRUE) == ERROR) {
+        return ERROR;
+    }
+
+    _map_workspaceReset(ws);
+    *path = NULL;
+    *len = 0;
+
+    //en componentes distintas no hace falta buscar
+    if(_map_knownUnreachable(mp, src, dst) == TRUE) {
+        return END;
+    }
+
+    if(_map_isOpen(mp, src) == FALSE) {
+        return END;
+    }
+
+    ws->mark[src] = ws->gen;
+    ws->pred[src] = src;
+    ws->cost[src] = 0;
+    heap_push(ws->heap, src, ASTAR_KEY(0, _map_heuristic(mp, src, dst)));
+
+    ws->mark2[dst] = ws->gen;
+    ws->pred2[dst] = dst;
+    ws->cost2[dst] = 0;
+    heap_push(ws->heap2, dst, ASTAR_KEY(0, _map_heuristic(mp, dst, src)));
+
+    best = src == dst ? 0 : UINT32_MAX;
+    meet = src;
+
+    /* la f minima de cada frontera es una cota inferior de cualquier camino
+       que falte por encontrar: se para en cuanto una de ellas alcanza best */
+    while(heap_isEmpty(ws->heap) == FALSE && heap_isEmpty(ws->heap2) == FALSE
+          && ASTAR_F(heap_topKey(ws->heap)) < best && ASTAR_F(heap_topKey(ws->heap2)) < best) {
+        if(heap_size(ws->heap) <= heap_size(ws->heap2)) {
+            _map_astarStep(mp, ws, ws->mark, ws->pred, ws->cost, ws->heap, ws->mark2, ws->cost2, dst, &best, &meet);
+        }
+        else {
+            _map_astarStep(mp, ws, ws->mark2, ws->pred2, ws->cost2, ws->heap2, ws->mark, ws->cost, src, &best, &meet);
+        }
+    }
+
+    heap_clear(ws->heap);
+    heap_clear(ws->heap2);
+
+    if(best == UINT32_MAX) {
+        return END;
+    }
+
+    //src -> meet con pred y meet -> dst con pred2
+    _map_buildPath(ws, src, (uint32_t) meet, path, len);
+    n = *len;
+    for(i=(uint32_t) meet, k=n; i != dst; k++) {
+        i = ws->pred2[i];
+        ws->queue[k] = i;
+    }
+    *len = k;
+
+    return OK;
+}
+
+Status map_astarBidirectional (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len) {
+    if(!mp) {
+        return ERROR;
+    }
+
+    return map_astarBidirectionalBetween(mp, ws, map_getInputIndex(mp), map_getOutputIndex(mp), path, len);
+}
+
+//Jump Point Search
+
+/* Salto horizontal desde la celda i en la direccion dir (RIGHT o LEFT): 
+   devuelve el primer punto de salto (destino o celda con un vecino vertical
+   forzado) o MAP_NOCELL */
+static size_t _map_jumpH (const Map *mp, size_t i, int dir, size_t dst) {
+    const uint8_t v = MAP_MASK(UP) | MAP_MASK(DOWN);
+    long step = _map_offset(mp, dir);
+
+    while(_map_mask(mp, i) & MAP_MASK(dir)) {
+        i += step;
+        if(i == dst) {
+            return dst;
+        }
+        //vecino vertical abierto que no lo estaba en la celda anterior
+        if(_map_mask(mp, i) & v & ~_map_mask(mp, i - step)) {
+            return i;
+        }
+    }
+
+    return MAP_NOCELL;
+}
+
+/* Salto vertical desde la celda i en la direccion dir (UP o DOWN): ademas 
+   de los vecinos forzados, se para en las filas desde las que un salto 
+   horizontal encuentra algun punto de salto */
+static size_t _map_jumpV (const Map *mp, size_t i, int dir, size_t dst) {
+    const uint8_t h = MAP_MASK(LEFT) | MAP_MASK(RIGHT);
+    long step = _map_offset(mp, dir);
+
+    while(_map_mask(mp, i) & MAP_MASK(dir)) {
+        i += step;
+        if(i == dst) {
+            return dst;
+        }
+        if(_map_mask(mp, i) & h & ~_map_mask(mp, i - step)) {
+            return i;
+        }
+        if(_map_jumpH(mp, i, RIGHT, dst) != MAP_NOCELL || _map_jumpH(mp, i, LEFT, dst) != MAP_NOCELL) {
+            return i;
+        }
+    }
+
+    return MAP_NOCELL;
+}
+
+Status map_jpsBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len) {
+    size_t cap, i, a, jp, k, p;
+    int d, ndirs, dirs[4];
+    uint32_t g;
+
+    cap = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !ws || !path || !len || cap > ws->capacity || src >= cap || dst >= cap) {
+        return ERROR;
+    }
+
+    if(_map_workspaceAstar(ws, FALSE) == ERROR) {
+        return ERROR;
+    }
+
+    _map_workspaceReset(ws);
+    *path = NULL;
+    *len = 0;
+
+    //en componentes distintas no hace falta buscar
+    if(_map_knownUnreachable(mp, src, dst) == TRUE) {
+        return END;
+    }
+
+    if(_map_isOpen(mp, src) == FALSE) {
+        return END;
+    }
+
+    //A* sobre los puntos de salto: pred guarda el punto de salto anterior
+    ws->mark[src] = ws->gen;
+    ws->pred[src] = src;
+    ws->cost[src] = 0;
+    heap_push(ws->heap, src, ASTAR_KEY(0, _map_heuristic(mp, src, dst)));
+
+    while(heap_isEmpty(ws->heap) == FALSE) {
+        i = heap_pop(ws->heap);
+        ws->expanded++;
+
+        if(i == dst) {
+            heap_clear(ws->heap);
+
+            //deshacer los saltos celda a celda
+            k = *len = (size_t)ws->cost[dst] + 1;
+            ws->queue[--k] = (uint32_t) i;
+            while(i != src) {
+                a = ws->pred[i];
+                while(i != a) {
+                    if(a / mp->ncols == i / mp->ncols) {
+                        i = a > i ? i + 1 : i - 1;
+                    }
+                    else {
+                        i = a > i ? i + mp->ncols : i - mp->ncols;
+                    }
+                    ws->queue[--k] = (uint32_t) i;
+                }
+            }
+            *path = ws->queue;
+            return OK;
+        }
+
+        /* poda: al llegar en horizontal se sigue recto o se gira en vertical,
+           al llegar en vertical se sigue recto o se gira en horizontal */
+        p = ws->pred[i];
+        ndirs = 0;
+        if(p == i) {
+            dirs[ndirs++] = RIGHT;
+            dirs[ndirs++] = UP;
+            dirs[ndirs++] = LEFT;
+            dirs[ndirs++] = DOWN;
+        }
+        else if(p / mp->ncols == i / mp->ncols) {
+            dirs[ndirs++] = p < i ? RIGHT : LEFT;
+            dirs[ndirs++] = UP;
+            dirs[ndirs++] = DOWN;
+        }
+        else {
+            dirs[ndirs++] = p < i ? DOWN : UP;
+            dirs[ndirs++] = LEFT;
+            dirs[ndirs++] = RIGHT;
+        }
+
+        for(d=0; d < ndirs; d++) {
+            if(dirs[d] == RIGHT || dirs[d] == LEFT) {
+                jp = _map_jumpH(mp, i, dirs[d], dst);
+            }
+            else {
+                jp = _map_jumpV(mp, i, dirs[d], dst);
+            }
+            if(jp == MAP_NOCELL) {
+                continue;
+            }
+
+            g = ws->cost[i] + _map_heuristic(mp, i, jp);
+            if(ws->mark[jp] != ws->gen || g < ws->cost[jp]) {
+                ws->mark[jp] = ws->gen;
+                ws->pred[jp] = (uint32_t) i;
+                ws->cost[jp] = g;
+                heap_push(ws->heap, (uint32_t) jp, ASTAR_KEY(g, _map_heuristic(mp, jp, dst)));
+            }
+        }
+    }
+
+    return END;
+}
+
+Status map_jps (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len) {
+    if(!mp) {
+        return ERROR;
+    }
+
+    return map_jpsBetween(mp, ws, map_getInputIndex(mp), map_getOutputIndex(mp), path, len);
+}
+//Campos de distancias
+
+Status map_bfsDistances (const Map *mp, const uint32_t *sources, size_t nsources, uint32_t *dist) {
+    size_t n, head, tail, i;
+    uint32_t *queue, u, v;
+    uint8_t m;
+
+    n = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !dist || (nsources > 0 && !sources)) {
+        return ERROR;
+    }
+
+    //la mascara de un muro no tiene por que ser 0: no puede ser fuente
+    for(i=0; i < nsources; i++) {
+        if(sources[i] >= n || _map_isOpen(mp, sources[i]) == FALSE) {
+            return ERROR;
+        }
+    }
+
+    queue = (uint32_t*) malloc((n ? n : 1) * sizeof(uint32_t));
+    if(!queue) {
+        return ERROR;
+    }
+
+    for(i=0; i < n; i++) {
+        dist[i] = MAP_NODIST;
+    }
+
+    //cada celda entra en la cola como mucho una vez, no hace falta que sea circular
+    head = tail = 0;
+    for(i=0; i < nsources; i++) {
+        if(dist[sources[i]] == MAP_NODIST) {
+            dist[sources[i]] = 0;
+            queue[tail++] = sources[i];
+        }
+    }
+
+    while(head < tail) {
+        u = queue[head++];
+        for(m = _map_mask(mp, u); m; m &= (uint8_t)(m - 1)) {
+            v = (uint32_t)((long) u + _map_offset(mp, __builtin_ctz(m)));
+            if(dist[v] == MAP_NODIST) {
+                dist[v] = dist[u] + 1;
+                queue[tail++] = v;
+            }
+        }
+    }
+
+    free(queue);
+
+    return OK;
+}
+
+/* Calcula el campo de las fuentes dadas */
+static Status _map_computeField (Map *mp, const uint32_t *src, size_t nsrc) {
+    if(map_bfsDistances(mp, src, nsrc, mp->field) == ERROR) {
+        return ERROR;
+    }
+    mp->field_valid = TRUE;
+
+    return OK;
+}
+
+/* Recalcula el campo guardado si alguna celda ha cambiado */
+static const uint32_t * _map_validField (Map *mp) {
+    uint32_t out;
+
+    if(mp->field_valid == TRUE) {
+        return mp->field;
+    }
+
+    if(mp->field_src) {
+        return _map_computeField(mp, mp->field_src, mp->field_nsrc) == OK ? mp->field : NULL;
+    }
+
+    if(mp->output_idx == MAP_NOCELL || _map_isOpen(mp, mp->output_idx) == FALSE) {
+        return NULL;
+    }
+    out = (uint32_t) mp->output_idx;
+
+    return _map_computeField(mp, &out, 1) == OK ? mp->field : NULL;
+}
+
+const uint32_t * map_distanceField (Map *mp, const uint32_t *sources, size_t nsources) {
+    size_t n, i;
+    uint32_t *src = NULL;
+
+    n = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || (nsources > 0 && !sources)) {
+        return NULL;
+    }
+
+    for(i=0; i < nsources; i++) {
+        if(sources[i] >= n || _map_isOpen(mp, sources[i]) == FALSE) {
+            return NULL;
+        }
+    }
+
+    //mismas fuentes que el campo guardado: se reutiliza
+    if(mp->field && mp->field_nsrc == nsources && (nsources == 0 || memcmp(mp->field_src, sources, nsources * sizeof(uint32_t)) == 0)) {
+        return _map_validField(mp);
+    }
+
+    if(!mp->field) {
+        mp->field = (uint32_t*) malloc((n ? n : 1) * sizeof(uint32_t));
+        if(!mp->field) {
+            return NULL;
+        }
+    }
+
+    if(nsources > 0) {
+        src = (uint32_t*) malloc(nsources * sizeof(uint32_t));
+        if(!src) {
+            return NULL;
+        }
+        memcpy(src, sources, nsources * sizeof(uint32_t));
+    }
+
+    free(mp->field_src);
+    mp->field_src = src;
+    mp->field_nsrc = nsources;
+    mp->field_valid = FALSE;
+
+    return _map_validField(mp);
+}
+
+uint32_t map_getFieldDistance (Map *mp, uint32_t i) {
+    const uint32_t *field;
+
+    if(!mp || i >= (size_t)mp->nrows * mp->ncols) {
+        return MAP_NODIST;
+    }
+
+    field = mp->field ? _map_validField(mp) : map_distanceField(mp, NULL, 0);
+    if(!field) {
+        return MAP_NODIST;
+    }
+
+    return field[i];
+}
+
+Status map_fieldPath (Map *mp, MapWorkspace *ws, uint32_t src, const uint32_t **path, size_t *len) {
+    const uint32_t *field;
+    size_t cap, i, k, nb[4];
+    uint32_t d;
+    int j, m;
+
+    cap = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp || !ws || !path || !len || cap > ws->capacity || src >= cap) {
+        return ERROR;
+    }
+
+    if(_map_workspaceBfs(ws) == ERROR) {
+        return ERROR;
+    }
+
+    field = mp->field ? _map_validField(mp) : map_distanceField(mp, NULL, 0);
+    if(!field) {
+        return ERROR;
+    }
+
+    *path = NULL;
+    *len = 0;
+    ws->expanded = 0;
+    if(field[src] == MAP_NODIST) {
+        return END;
+    }
+
+    //descenso: siempre hay un vecino a una distancia menos de la fuente
+    i = src;
+    for(k=0, d=field[src]; ; k++, d--) {
+        ws->queue[k] = (uint32_t) i;
+        if(d == 0) {
+            break;
+        }
+        m = _map_neighbours(mp, i, nb);
+        for(j=0; j < m && field[nb[j]] != d - 1; j++);
+        i = nb[j];
+    }
+
+    ws->expanded = k + 1;
+    *path = ws->queue;
+    *len = k + 1;
+
+    return OK;
+}
+
+//Componentes conexas
+
+/* Raiz de la componente de la celda i, sin modificar el mapa */
+static uint32_t _map_componentRoot (const Map *mp, uint32_t i) {
+    while(mp->comp[i] != i) {
+        i = mp->comp[i];
+    }
+
+    return i;
+}
+
+/* Raiz de la componente de la celda i, acortando el camino a la mitad */
+static uint32_t _map_find (Map *mp, uint32_t i) {
+    while(mp->comp[i] != i) {
+        mp->comp[i] = mp->comp[mp->comp[i]];
+        i = mp->comp[i];
+    }
+
+    return i;
+}
+
+/* Une las componentes de las celdas a y b: la raiz es siempre la menor */
+static void _map_union (Map *mp, uint32_t a, uint32_t b) {
+    a = _map_find(mp, a);
+    b = _map_find(mp, b);
+    if(a < b) {
+        mp->comp[b] = a;
+    }
+    else if(b < a) {
+        mp->comp[a] = b;
+    }
+}
+
+/* Indica si ya se sabe, sin buscar, que no hay camino entre src y dst */
+static Bool _map_knownUnreachable (const Map *mp, size_t src, size_t dst) {
+    if(mp->comp_valid == FALSE || mp->comp[src] == MAP_NOINDEX || mp->comp[dst] == MAP_NOINDEX) {
+        return FALSE;
+    }
+
+    return _map_componentRoot(mp, (uint32_t) src) != _map_componentRoot(mp, (uint32_t) dst) ? TRUE : FALSE;
+}
+
+/* La celda i ha cambiado: una barrera que se abre une componentes; un 
+   muro nuevo puede partir una y obliga a etiquetar de nuevo */
+static void _map_componentsChanged (Map *mp, size_t i) {
+    size_t nb[4];
+    int k, n;
+
+    if(mp->comp_valid == FALSE) {
+        return;
+    }
+
+    if(_map_isOpen(mp, i) == TRUE) {
+        if(mp->comp[i] == MAP_NOINDEX) {
+            mp->comp[i] = (uint32_t) i;
+            n = _map_neighbours(mp, i, nb);
+            for(k=0; k < n; k++) {
+                _map_union(mp, (uint32_t) i, (uint32_t) nb[k]);
+            }
+        }
+    }
+    else if(mp->comp[i] != MAP_NOINDEX) {
+        mp->comp_valid = FALSE;
+    }
+}
+
+Status map_labelComponents (Map *mp) {
+    size_t n, i;
+    uint8_t m;
+    Bool direct;
+
+    n = mp ? (size_t)mp->nrows * mp->ncols : 0;
+    if(!mp) {
+        return ERROR;
+    }
+
+    if(!mp->comp) {
+        mp->comp = (uint32_t*) malloc((n ? n : 1) * sizeof(uint32_t));
+        if(!mp->comp) {
+            return ERROR;
+        }
+    }
+
+    //una pasada por filas: cada celda solo se une con la de su izquierda y la de arriba
+    direct = (mp->compact == TRUE && mp->stride == mp->ncols) ? TRUE : FALSE;
+    for(i=0; i < n; i++) {
+        //en modo compacto sin relleno el simbolo se lee directamente
+        if(direct == TRUE ? (mp->symbols[i] == BARRIER || mp->symbols[i] == ERRORCHAR) : _map_isOpen(mp, i) == FALSE) {
+            mp->comp[i] = MAP_NOINDEX;
+            continue;
+        }
+        m = _map_mask(mp, i);
+        if(m & MAP_MASK(LEFT)) {
+            mp->comp[i] = _map_find(mp, (uint32_t)(i - 1));
+            if(m & MAP_MASK(UP)) {
+                _map_union(mp, mp->comp[i], (uint32_t)(i - mp->ncols));
+            }
+        }
+        else if(m & MAP_MASK(UP)) {
+            mp->comp[i] = _map_find(mp, (uint32_t)(i - mp->ncols));
+        }
+        else {
+            mp->comp[i] = (uint32_t) i;
+        }
+    }
+
+    //el padre tiene un indice menor y ya apunta a su raiz
+    for(i=0; i < n; i++) {
+        if(mp->comp[i] != MAP_NOINDEX) {
+            mp->comp[i] = mp->comp[mp->comp[i]];
+        }
+    }
+    mp->comp_valid = TRUE;
+
+    return OK;
+}
+
+uint32_t map_getComponent (Map *mp, uint32_t i) {
+    if(!mp || i >= (size_t)mp->nrows * mp->ncols) {
+        return MAP_NOINDEX;
+    }
+
+    if(mp->comp_valid == FALSE && map_labelComponents(mp) == ERROR) {
+        return MAP_NOINDEX;
+    }
+
+    if(mp->comp[i] == MAP_NOINDEX) {
+        return MAP_NOINDEX;
+    }
+
+    return _map_find(mp, i);
+}
+
+Bool map_isReachable (Map *mp, uint32_t src, uint32_t dst) {
+    uint32_t c;
+
+    c = map_getComponent(mp, src);
+    if(c == MAP_NOINDEX) {
+        return FALSE;
+    }
+
+    return c == map_getComponent(mp, dst) ? TRUE : FALSE;
 }
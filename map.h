@@ -8,8 +8,14 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <stdint.h>
 #include "point.h"
 
+/* Cell index meaning "no cell". Cells are numbered row-major: (x, y) is y*ncols + x */
+#define MAP_NOINDEX UINT32_MAX
+/* Distance of the cells that cannot be reached from the sources of a distance field */
+#define MAP_NODIST UINT32_MAX
+
 typedef enum {
     RIGHT = 0,
     UP = 1,
@@ -18,8 +24,25 @@ typedef enum {
     STAY = 4,
 } Position;
 
+/* Bit of a neighboor mask for the neighboor at position pos */
+#define MAP_MASK(pos) (1u << (pos))
+
 typedef struct _Map Map;
 
+typedef struct _MapWorkspace MapWorkspace;
+
+/**
+ * @brief Lightweight view of a map cell.
+ *
+ * Copy of the data of one cell, valid in both the normal and the 
+ * compact map modes. Modifying a view does not modify the map.
+ **/
+typedef struct {
+    int x, y;
+    char symbol;
+    Bool visited;
+} MapCell;
+
 
 /**
  * @brief  Creates a new empty Map with nrows and ncols.
@@ -27,13 +50,41 @@ typedef struct _Map Map;
  * Allocates memory for a new map and initializes it to be empty 
  * (no points).
  * 
- * @param nrows, ncols Dimension of the map 
+ * @param nrows, ncols Dimension of the map, nrows*ncols must be lower
+ * than MAP_NOINDEX
  *
  * @return A pointer to the graph if it was correctly allocated, 
  * NULL otherwise.
  **/
 Map * map_new (unsigned int nrows,  unsigned int ncols);
 
+/**
+ * @brief  Creates a new compact Map with nrows and ncols.
+ *
+ * A compact map does not keep Point objects. It stores one byte per 
+ * cell with its symbol plus one visited bit per cell, and the 
+ * coordinates are worked out from the cell position. All the cells 
+ * are initialized to SPACE.
+ * 
+ * In compact mode map_getPoint, map_getNeighboor, map_getInput and 
+ * map_getOutput return NULL; use the MapCell view functions instead.
+ * 
+ * @param nrows, ncols Dimension of the map 
+ *
+ * @return A pointer to the map if it was correctly allocated, 
+ * NULL otherwise.
+ **/
+Map * map_newCompact (unsigned int nrows,  unsigned int ncols);
+
+/**
+ * @brief  Tells whether a map was created in compact mode.
+ *
+ * @param mp Pointer to the map.
+ *
+ * @return TRUE for compact maps, FALSE otherwise or on error.
+ **/
+Bool map_isCompact (const Map *mp);
+
 
 /**
  * @brief Frees a graph.
@@ -50,6 +101,9 @@ void map_free (Map *);
  * Insert a point in the map at the coordinates indicated by the point. 
  * The upper left corner point of the map has (0,0) coordinates.
  *
+ * In compact mode only the symbol of the point is copied into the map
+ * and the caller keeps the ownership of p.
+ *
  * @param mp Pointer to the map.
  * @param p Pointer to the point to be inserted.
  *
@@ -93,6 +147,10 @@ Point * map_getOutput (const Map *mp);
  * 
  * @return Returns pointer to the map point , or NULL if 
  * there is any error.
+ *
+ * The points of a map notify it when their symbol changes, so 
+ * point_setSymbol on the returned point has the same effect as 
+ * map_setCellSymbol.
  **/
 Point *map_getPoint (const Map *mp, const Point *p);
 
@@ -108,6 +166,9 @@ Point *map_getPoint (const Map *mp, const Point *p);
  * 
  * @return Returns pointer to the neighboor, or NULL if 
  * there is any error.
+ *
+ * Searches should use map_getNeighboors, which does not go through the
+ * points.
  **/
 Point *map_getNeighboor(const Map *mp, const Point *p, Position pos);
 
@@ -115,6 +176,150 @@ Point *map_getNeighboor(const Map *mp, const Point *p, Position pos);
 Status map_setInput(Map *mp, Point *p);
 Status map_setOutput (Map *mp,Point *p);
 
+/**
+ * @brief  Gets a view of the cell at (x, y).
+ *
+ * @param mp Pointer to the map.
+ * @param x, y Cell coordinates
+ * @param cell Where the view is stored
+ *
+ * @return Returns OK or ERROR if the cell is out of the map.
+ **/
+Status map_getCell (const Map *mp, int x, int y, MapCell *cell);
+
+/**
+ * @brief  Gets a view of the neighboor of a cell at the position pos.
+ *
+ * @param mp Pointer to the map.
+ * @param cell View of the cell
+ * @param pos Neighboor position relative to the cell
+ * @param neighboor Where the view of the neighboor is stored
+ *
+ * @return Returns OK or ERROR if the neighboor is out of the map.
+ **/
+Status map_getCellNeighboor (const Map *mp, const MapCell *cell, Position pos, MapCell *neighboor);
+
+/**
+ * @brief  Gets a view of the input (output) cell of the map.
+ *
+ * @param mp Pointer to the map.
+ * @param cell Where the view is stored
+ *
+ * @return Returns OK or ERROR if the map has no input (output).
+ **/
+Status map_getInputCell (const Map *mp, MapCell *cell);
+Status map_getOutputCell (const Map *mp, MapCell *cell);
+
+/**
+ * @brief  Modifies the symbol of the cell at (x, y).
+ *
+ * The neighboor masks are kept up to date and the listener set with 
+ * map_setCellListener is notified. point_setSymbol on a point of the 
+ * map does the same.
+ *
+ * @param mp Pointer to the map.
+ * @param x, y Cell coordinates
+ * @param symbol New symbol
+ *
+ * @return Returns OK or ERROR in case of error.
+ **/
+Status map_setCellSymbol (Map *mp, int x, int y, char symbol);
+
+/**
+ * @brief: Function called by map_setCellSymbol, point_setSymbol on a 
+ * point of the map and map_insertPoint after the cell i of mp has 
+ * changed, once the neighboor masks are up to date
+ **/
+typedef void (*P_map_cellChanged)(void *data, const Map *mp, uint32_t i);
+
+/**
+ * @brief  Sets the function notified of the changes of the cells of a 
+ * map, as an incremental planner (mapplan.h) does. A map has at most 
+ * one listener.
+ *
+ * @param mp Pointer to the map.
+ * @param listener Function to call, NULL to remove the current one
+ * @param data First argument of every call
+ *
+ * @return Returns OK, or ERROR if mp is NULL or it already has a listener
+ **/
+Status map_setCellListener (Map *mp, P_map_cellChanged listener, void *data);
+
+/**
+ * @brief  Modifies the visited flag of the cell at (x, y).
+ *
+ * @param mp Pointer to the map.
+ * @param x, y Cell coordinates
+ * @param visited New visited flag
+ *
+ * @return Returns OK or ERROR in case of error.
+ **/
+Status map_setCellVisited (Map *mp, int x, int y, Bool visited);
+
+/**
+ * @brief  Returns the index of the cell at (x, y).
+ *
+ * Cells are numbered row-major, the cell (x, y) has index y*ncols + x.
+ *
+ * @param mp Pointer to the map.
+ * @param x, y Cell coordinates
+ *
+ * @return Returns the index or MAP_NOINDEX if the cell is out of the map.
+ **/
+uint32_t map_getCellIndex (const Map *mp, int x, int y);
+
+/**
+ * @brief  Returns the index of the input (output) cell of the map.
+ *
+ * @param mp Pointer to the map.
+ *
+ * @return Returns the index or MAP_NOINDEX if the map has no input 
+ * (output).
+ **/
+uint32_t map_getInputIndex (const Map *mp);
+uint32_t map_getOutputIndex (const Map *mp);
+
+/**
+ * @brief  Returns the neighboor mask of the cell with index i.
+ *
+ * The mask is computed when the map is loaded and kept up to date by 
+ * map_insertPoint and map_setCellSymbol. Bit MAP_MASK(pos) is set if the 
+ * neighboor at pos (RIGHT, UP, LEFT or DOWN) is inside the map and is 
+ * not a BARRIER.
+ *
+ * @param mp Pointer to the map.
+ * @param i Cell index
+ *
+ * @return Returns the mask, 0 in case of error.
+ **/
+uint8_t map_getNeighboorMask (const Map *mp, uint32_t i);
+
+/**
+ * @brief  Gets the indices of the passable neighboors of a cell.
+ *
+ * Walks the set bits of the neighboor mask, in the order RIGHT, UP, 
+ * LEFT, DOWN, without calling map_getNeighboor.
+ *
+ * @param mp Pointer to the map.
+ * @param i Cell index
+ * @param nb Where the indices of the neighboors are stored
+ *
+ * @return Returns the number of neighboors stored in nb, -1 in case 
+ * of error.
+ **/
+int map_getNeighboors (const Map *mp, uint32_t i, uint32_t nb[4]);
+
+/**
+ * @brief  Gets a view of the cell with index i.
+ *
+ * @param mp Pointer to the map.
+ * @param i Cell index
+ * @param cell Where the view is stored
+ *
+ * @return Returns OK or ERROR if the cell is out of the map.
+ **/
+Status map_getCellByIndex (const Map *mp, uint32_t i, MapCell *cell);
+
 /* START [map_readFromFile] */
 /**
  * @brief Reads a map definition from a text file.
@@ -143,6 +348,100 @@ Status map_setOutput (Map *mp,Point *p);
  */
 Map * map_readFromFile (FILE *pf);   
 
+/**
+ * @brief Reads a map definition from a text file into a compact map.
+ *
+ * Same file format as map_readFromFile, but the map is created with
+ * map_newCompact, so no Point is allocated.
+ *
+ * @param pf, Pointer to the input stream.
+ *
+ * @return the map or NULL if there is any error
+ */
+Map * map_readFromFileCompact (FILE *pf);
+
+/**
+ * @brief Reads a map definition from a text file, reporting where the 
+ * file is malformed.
+ *
+ * Same file format as map_readFromFile. The rest of the stream is read
+ * at once and each row is checked and copied in bulk; rows may end 
+ * with "\n" or "\r\n" and the last one may have no line end. Every 
+ * row must have exactly ncols symbols.
+ *
+ * @code
+ * int line, col;
+ * Map *mp = map_load (pf, FALSE, &line, &col);
+ * if (!mp && line > 0) fprintf (stderr, "error at %d:%d\n", line, col);
+ * @endcode
+ *
+ * @param pf, Pointer to the input stream, read until its end
+ * @param compact, TRUE to create a compact map
+ * @param err_line, err_col, If not NULL, where the line and column 
+ * (starting at 1) of the first error of the file are stored, or 0 if 
+ * the error is not in the file contents (e.g. out of memory)
+ *
+ * @return the map or NULL if there is any error
+ */
+Map * map_load (FILE *pf, Bool compact, int *err_line, int *err_col);
+
+/**
+ * @brief Opens a map file as a read-only compact map without copying it.
+ *
+ * The file is mapped in memory with mmap and the symbols of the map are
+ * the bytes of the file itself, read in place (rows are ncols + 1 
+ * bytes apart, ncols + 2 with "\r\n" line ends). Without find_ends 
+ * only the header, the first line end and the file size are checked, 
+ * so opening does not depend on the size of the map; any byte of the 
+ * grid that is not SPACE, INPUT or OUTPUT is then taken as a BARRIER.
+ * With find_ends every row is checked as map_load does. Visited flags 
+ * are kept in a separate bitset and the neighboor masks are computed 
+ * on the fly.
+ *
+ * The map cannot be modified: map_insertPoint and map_setCellSymbol 
+ * fail. It stays valid until map_free, which unmaps the file.
+ *
+ * @param filename, Path of the map file
+ * @param find_ends, TRUE to locate the input and output cells, which 
+ * reads the whole file; with FALSE use the searches that take the two 
+ * end cells (map_bfsBetween...)
+ * @param err_line, err_col, If not NULL, where the position of a format
+ * error is stored, as in map_load
+ *
+ * @return the map or NULL if there is any error
+ */
+Map * map_mmapFile (const char *filename, Bool find_ends, int *err_line, int *err_col);
+
+/**
+ * @brief Writes a map in the binary compact format.
+ *
+ * The file has a 28 byte header (magic "MAZB", version, number of rows 
+ * and columns, input and output cell indices and a checksum, all of 
+ * them little-endian) followed by the cells packed with 2 bits each
+ * (BARRIER, SPACE, INPUT, OUTPUT), about 30 times smaller than the 
+ * text written by map_print.
+ *
+ * @param pf, Pointer to the output stream, opened in binary mode
+ * @param mp, Pointer to the map
+ *
+ * @return OK, or ERROR if the map has a symbol other than the four 
+ * above or the file cannot be written
+ */
+Status map_saveBinary (FILE *pf, const Map *mp);
+
+/**
+ * @brief Reads a map written by map_saveBinary.
+ *
+ * The cells are read with a single fread and the header (version, 
+ * dimensions, checksum, input and output) is validated.
+ *
+ * @param pf, Pointer to the input stream, opened in binary mode
+ * @param compact, TRUE to create a compact map
+ *
+ * @return the map or NULL if there is any error
+ */
+Map * map_loadBinary (FILE *pf, Bool compact);
+
 /* END [map_readFromFile] */
 
 /**
@@ -176,12 +475,59 @@ Bool map_equal (const void *_mp1, const void *_mp2);
  */
 int map_print (FILE*pf, Map *mp);   
 
+/** 
+ * @brief Prints in pf a map using a caller-supplied buffer.
+ *
+ * Renders the map without printf into buf, which is written with a 
+ * single fwrite each time it fills up, so large maps need a handful of
+ * writes instead of one fprintf per cell. The buffer can be reused.
+ * With raw = TRUE the text of a laberinto file is written ("nrows ncols"
+ * and a line of symbols per row), which map_load reads back.
+ *
+ * @code
+ * char buf[1 << 16];
+ * map_printBuffered (stdout, mp, buf, sizeof (buf), FALSE);
+ * @endcode
+ *
+ * @param pf File descriptor
+ * @param mp map to be printed
+ * @param buf Buffer
+ * @param size Size of the buffer, at least POINT_RENDER_MAX
+ * @param raw TRUE to write the text of a laberinto file, FALSE to write
+ * the same as map_print
+ *
+ * @return Returns the number of characters that have been written 
+ * successfully, the header and the line ends included (map_print only
+ * counts the points). If there have been errors returns -1.
+ */
+int map_printBuffered (FILE *pf, const Map *mp, char *buf, size_t size, Bool raw);
+
+/** 
+ * @brief Prints in pf the cells of a path using a caller-supplied buffer.
+ *
+ * The cells are written one after another with the format of point_print.
+ *
+ * @param pf File descriptor
+ * @param mp map the path belongs to
+ * @param path Cell indices, as returned by the searches
+ * @param len Number of cells
+ * @param buf Buffer
+ * @param size Size of the buffer, at least POINT_RENDER_MAX
+ *
+ * @return Returns the number of characters that have been written 
+ * successfully. If there have been errors returns -1.
+ */
+int map_printPath (FILE *pf, const Map *mp, const uint32_t *path, size_t len, char *buf, size_t size);
+
 /* START [_DFS] */
 /**
  * @brief: Makes a search from the origin point to the output point
  * of a map using the depth-first search algorithm and the ADT Stack
  *
- * The function prints each visited point while traversing the map
+ * The function prints each visited point while traversing the map.
+ * The search is iterative and uses the visited flag of the points, which
+ * are reset at the beginning. Compact maps are not supported, use
+ * map_dfsWorkspace instead.
  *
  * @param mp, Pointer to map
  * @param pf, File descriptor 
@@ -191,5 +537,285 @@ int map_print (FILE*pf, Map *mp);
 Point * map_dfs (FILE *pf, Map *mp);  
 /* END [_DFS] */
 
+/**
+ * @brief Creates a search workspace for a map.
+ *
+ * A workspace keeps all the memory a search needs (stack, visited 
+ * marks...), so that repeated searches over the same map do not 
+ * allocate. It can be reused with any map with the same or a smaller
+ * number of cells. A workspace must not be shared by two searches 
+ * running at the same time.
+ *
+ * @param mp, Pointer to map
+ * 
+ * @return The new workspace or NULL in case of error
+**/
+MapWorkspace * map_workspaceNew (const Map *mp);
+
+/**
+ * @brief Returns the number of cells expanded by the last search made 
+ * with a workspace.
+ *
+ * A cell is expanded when the search takes it from its stack, queue or 
+ * open set to look at its neighboors.
+ *
+ * @param ws, Pointer to the workspace
+ * 
+ * @return The number of expanded cells, 0 in case of error
+**/
+size_t map_workspaceExpanded (const MapWorkspace *ws);
+
+/**
+ * @brief Frees a search workspace.
+ *
+ * @param ws, Pointer to the workspace
+**/
+void map_workspaceFree (MapWorkspace *ws);
+
+/**
+ * @brief: Makes a depth-first search from the input point to the output 
+ * point of a map using a caller-owned workspace.
+ *
+ * The map is not modified (visited flags are kept in the workspace), so
+ * it works with normal and compact maps and does not allocate memory.
+ *
+ * @param pf, File descriptor where each visited cell is printed, or 
+ * NULL to print nothing
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * 
+ * @return OK if the output was reached, END if it is not reachable from
+ * the input, ERROR in case of invalid parameters
+**/
+Status map_dfsWorkspace (FILE *pf, const Map *mp, MapWorkspace *ws);
+
+/**
+ * @brief: Finds the shortest path from the input point to the output 
+ * point of a map using the breadth-first search algorithm.
+ *
+ * The path is returned as the array of the indices of its cells, from 
+ * the input to the output, both included. The array belongs to the
+ * workspace and is valid until the next search made with it. After the
+ * first search no memory is allocated.
+ *
+ * @code
+ * const uint32_t *path;
+ * size_t len;
+ * if (map_bfs (mp, ws, &path, &len) == OK) {
+ *     // path[0] is the input, path[len-1] the output
+ * }
+ * @endcode
+ *
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * @param path, Where the address of the path is stored
+ * @param len, Where the number of cells of the path is stored
+ * 
+ * @return OK if a path was found, END if the output is not reachable,
+ * ERROR in case of error
+**/
+Status map_bfs (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Same as map_bfs, between any two cells of the map.
+ *
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * @param src, dst, Indices of the first and the last cell of the path
+ * @param path, Where the address of the path is stored
+ * @param len, Where the number of cells of the path is stored
+ * 
+ * @return OK if a path was found, END if dst is not reachable (also 
+ * when src or dst is a BARRIER), ERROR in case of error
+**/
+Status map_bfsBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Finds the shortest path from the input point to the output 
+ * point of a map using the A* algorithm.
+ *
+ * The open set is an indexed binary heap and the heuristic is the 
+ * Manhattan distance, the tightest admissible one for a grid with four
+ * neighboors (the euclidean distance of point_euDistance is admissible 
+ * too, but expands more cells). The path is returned as in map_bfs and
+ * has the same length.
+ *
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * @param path, Where the address of the path is stored
+ * @param len, Where the number of cells of the path is stored
+ * 
+ * @return OK if a path was found, END if the output is not reachable,
+ * ERROR in case of error
+**/
+Status map_astar (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Same as map_astar, between any two cells of the map. A 
+ * BARRIER src or dst gives END, as in map_bfsBetween.
+**/
+Status map_astarBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Bidirectional A*: searches at the same time from the input
+ * towards the output and from the output towards the input, and stops 
+ * when no unexplored path can be shorter than the best one found.
+ *
+ * Same parameters and return values as map_astar.
+**/
+Status map_astarBidirectional (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Same as map_astarBidirectional, between any two cells of the 
+ * map. A BARRIER src or dst gives END, as in map_bfsBetween.
+**/
+Status map_astarBidirectionalBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Finds the shortest path from the input point to the output 
+ * point of a map using Jump Point Search for grids with four neighboors.
+ *
+ * Instead of expanding the open cells one by one, the search jumps in
+ * straight lines over runs of open cells and only stops at the cells 
+ * where a shortest path may need to turn (jump points), so it is much
+ * faster than map_bfs or map_astar on maps that are mostly open floor.
+ * The path is returned cell by cell as in map_bfs and has the same 
+ * length. map_workspaceExpanded counts the expanded jump points.
+ *
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * @param path, Where the address of the path is stored
+ * @param len, Where the number of cells of the path is stored
+ * 
+ * @return OK if a path was found, END if the output is not reachable,
+ * ERROR in case of error
+**/
+Status map_jps (const Map *mp, MapWorkspace *ws, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Same as map_jps, between any two cells of the map.
+**/
+Status map_jpsBetween (const Map *mp, MapWorkspace *ws, uint32_t src, uint32_t dst, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Computes the distance from every cell of a map to the nearest
+ * of several source cells with a single BFS that starts at all of them.
+ * It is the serial BFS behind map_distanceField and mapbfs_distances.
+ *
+ * @param mp, Pointer to map
+ * @param sources, Indices of the source cells, none of them a BARRIER
+ * @param nsources, Number of sources
+ * @param dist, Array with one element per cell, where the distances are
+ * stored (MAP_NODIST for the barriers and the unreachable cells)
+ *
+ * @return OK, or ERROR in case of invalid parameters or not enough memory
+ **/
+Status map_bfsDistances (const Map *mp, const uint32_t *sources, size_t nsources, uint32_t *dist);
+
+/**
+ * @brief: Computes the distance field of a map: the number of steps 
+ * from every cell to the nearest of the source cells, all of them found
+ * by a single BFS that starts at every source at once (the map is not
+ * directed, so these are also the distances from the sources).
+ *
+ * The field is kept in the map and reused while the sources are the 
+ * same. map_setCellSymbol (or point_setSymbol on a point of the map), 
+ * map_insertPoint and, for the field of the output, map_setOutput mark 
+ * it as outdated, and it is computed again the next time it is needed.
+ *
+ * @param mp, Pointer to map
+ * @param sources, Indices of the source cells, none of them a BARRIER
+ * @param nsources, Number of sources; 0 to use the output cell
+ *
+ * @return the field, one distance per cell (MAP_NODIST for the barriers
+ * and the cells that cannot reach any source), which belongs to the map 
+ * and is valid until the map changes or is freed; NULL in case of error
+ **/
+const uint32_t * map_distanceField (Map *mp, const uint32_t *sources, size_t nsources);
+
+/**
+ * @brief: Distance from a cell to the nearest source of the distance 
+ * field of the map. If no field has been computed yet, computes the 
+ * one of the output cell.
+ *
+ * @param mp, Pointer to map
+ * @param i, Index of the cell
+ *
+ * @return the distance, or MAP_NODIST if the cell cannot reach any 
+ * source or in case of error
+ **/
+uint32_t map_getFieldDistance (Map *mp, uint32_t i);
+
+/**
+ * @brief: Finds the shortest path from a cell to the nearest source of 
+ * the distance field of the map (the output cell if no field has been 
+ * computed yet) by moving each step to a neighboor one step closer, so
+ * it only costs the length of the path once the field is computed:
+ * 
+ * map_distanceField (mp, NULL, 0);
+ * for (...) {
+ *    if (map_fieldPath (mp, ws, src, &path, &len) == OK) {...}
+ * }
+ *
+ * The path is returned as in map_bfs, from src to the source, and has
+ * the same length as the one found by map_bfsBetween.
+ *
+ * @param mp, Pointer to map
+ * @param ws, Workspace created for this map
+ * @param src, Index of the start cell
+ * @param path, Where the address of the path is stored
+ * @param len, Where the number of cells of the path is stored
+ *
+ * @return OK if a path was found, END if src cannot reach any source,
+ * ERROR in case of error
+ **/
+Status map_fieldPath (Map *mp, MapWorkspace *ws, uint32_t src, const uint32_t **path, size_t *len);
+
+/**
+ * @brief: Labels the connected components of the passable cells of a 
+ * map with a union-find over one pass by rows, so that map_isReachable
+ * is a comparison and the searches (map_bfsBetween, map_astarBetween, 
+ * map_astarBidirectionalBetween, map_jpsBetween) return END at once 
+ * when the two cells are in different components.
+ *
+ * map_load, map_readFromFile and map_loadBinary label the map they 
+ * return; map_mmapFile does not, so that opening a file stays O(1).
+ * The labels are kept up to date by map_setCellSymbol and 
+ * map_insertPoint: a BARRIER that becomes passable joins the components
+ * of its neighboors, while a passable cell that becomes a BARRIER may
+ * split its component and the map is labelled again on the next query.
+ *
+ * @param mp, Pointer to map
+ *
+ * @return OK, or ERROR in case of error or not enough memory
+ **/
+Status map_labelComponents (Map *mp);
+
+/**
+ * @brief: Returns the component of a cell: two cells are connected if 
+ * and only if they have the same component. Labels the map if needed.
+ *
+ * @param mp, Pointer to map
+ * @param i, Index of the cell
+ *
+ * @return the index of one cell of the component, or MAP_NOINDEX for 
+ * barriers and in case of error
+ **/
+uint32_t map_getComponent (Map *mp, uint32_t i);
+
+/**
+ * @brief: Checks whether there is a path between two cells, without 
+ * searching for it:
+ *
+ * if (map_isReachable (mp, map_getInputIndex (mp), map_getOutputIndex (mp)) == TRUE) {...}
+ *
+ * @param mp, Pointer to map
+ * @param src, dst, Indices of the two cells
+ *
+ * @return TRUE if both cells are passable and connected, FALSE otherwise
+ * or in case of error
+ **/
+Bool map_isReachable (Map *mp, uint32_t src, uint32_t dst);
+
 #endif /* MAP_H */
 
@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "mapbatch.h"
+
+/* Hilo del motor: su bloque de consultas pendientes es [lo, hi) */
+typedef struct {
+    struct _MapBatch *b;
+    int id;
+    MapWorkspace *ws;
+    pthread_mutex_t lock; // protege lo y hi, que otros hilos pueden robar
+    size_t lo, hi;
+} MapBatchWorker;
+
+struct _MapBatch {
+    const Map *mp;
+    int nthreads;
+    pthread_t *threads;
+    MapBatchWorker *workers;
+    pthread_mutex_t lock; // protege los campos de abajo
+    pthread_cond_t start; // se ha publicado una tanda nueva (o hay que terminar)
+    pthread_cond_t done; // el ultimo hilo ha terminado la tanda
+    unsigned long round; // numero de la tanda actual
+    int running; // hilos que no han terminado la tanda actual
+    Bool quit;
+    MapQuery *q;
+    P_map_search search;
+};
+
+/* Toma una consulta del bloque propio */
+static Bool _mapbatch_take (MapBatchWorker *w, size_t *i) {
+    Bool found = FALSE;
+
+    pthread_mutex_lock(&w->lock);
+    if(w->lo < w->hi) {
+        *i = w->lo++;
+        found = TRUE;
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return found;
+}
+
+/* Roba la mitad de lo que le queda a otro hilo; se queda con la primera y el resto pasa a ser su bloque */
+static Bool _mapbatch_steal (MapBatchWorker *w, size_t *i) {
+    MapBatch *b = w->b;
+    MapBatchWorker *v;
+    size_t lo = 0, hi = 0, take;
+    int k;
+
+    for(k=1; k < b->nthreads && hi == 0; k++) {
+        v = &b->workers[(w->id + k) % b->nthreads];
+        pthread_mutex_lock(&v->lock);
+        if(v->lo < v->hi) {
+            take = (v->hi - v->lo + 1) / 2;
+            hi = v->hi;
+            lo = v->hi - take;
+            v->hi = lo;
+        }
+        pthread_mutex_unlock(&v->lock);
+    }
+
+    if(hi == 0) {
+        return FALSE;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    w->lo = lo + 1;
+    w->hi = hi;
+    pthread_mutex_unlock(&w->lock);
+    *i = lo;
+
+    return TRUE;
+}
+
+/* Resuelve la consulta i y copia su camino */
+static void _mapbatch_answer (MapBatchWorker *w, size_t i) {
+    MapBatch *b = w->b;
+    MapQuery *q = &b->q[i];
+    const uint32_t *path;
+    size_t len;
+
+    q->path = NULL;
+    q->len = 0;
+    q->status = b->search(b->mp, w->ws, q->src, q->dst, &path, &len);
+    if(q->status != OK) {
+        return;
+    }
+
+    //el camino de la busqueda es del workspace, se copia antes de la siguiente
+    q->path = (uint32_t*) malloc(len * sizeof(uint32_t));
+    if(!q->path) {
+        q->status = ERROR;
+        return;
+    }
+    memcpy(q->path, path, len * sizeof(uint32_t));
+    q->len = len;
+}
+
+static void * _mapbatch_thread (void *arg) {
+    MapBatchWorker *w = (MapBatchWorker*) arg;
+    MapBatch *b = w->b;
+    unsigned long seen = 0;
+    size_t i;
+
+    pthread_mutex_lock(&b->lock);
+    for(;;) {
+        while(b->quit == FALSE && b->round == seen) {
+            pthread_cond_wait(&b->start, &b->lock);
+        }
+        if(b->quit == TRUE) {
+            break;
+        }
+        seen = b->round;
+        pthread_mutex_unlock(&b->lock);
+
+        while(_mapbatch_take(w, &i) == TRUE || _mapbatch_steal(w, &i) == TRUE) {
+            _mapbatch_answer(w, i);
+        }
+
+        pthread_mutex_lock(&b->lock);
+        if(--b->running == 0) {
+            pthread_cond_signal(&b->done);
+        }
+    }
+    pthread_mutex_unlock(&b->lock);
+
+    return NULL;
+}
+
+MapBatch * mapbatch_new (const Map *mp, int nthreads) {
+    MapBatch *b;
+    long online;
+    int k;
+
+    if(!mp || nthreads < 0) {
+        return NULL;
+    }
+
+    if(nthreads == 0) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = online > 0 ? (int) online : 1;
+    }
+
+    b = (MapBatch*) calloc(1, sizeof(MapBatch));
+    if(!b) {
+        return NULL;
+    }
+
+    b->mp = mp;
+    b->quit = FALSE;
+    b->threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    b->workers = (MapBatchWorker*) calloc(nthreads, sizeof(MapBatchWorker));
+    if(!b->threads || !b->workers) {
+        free(b->threads);
+        free(b->workers);
+        free(b);
+        return NULL;
+    }
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->start, NULL);
+    pthread_cond_init(&b->done, NULL);
+
+    //nthreads cuenta los hilos arrancados, para que mapbatch_free solo espere a esos
+    for(k=0; k < nthreads; k++) {
+        b->workers[k].b = b;
+        b->workers[k].id = k;
+        b->workers[k].ws = map_workspaceNew(mp);
+        pthread_mutex_init(&b->workers[k].lock, NULL);
+        if(!b->workers[k].ws || pthread_create(&b->threads[k], NULL, _mapbatch_thread, &b->workers[k]) != 0) {
+            map_workspaceFree(b->workers[k].ws);
+            pthread_mutex_destroy(&b->workers[k].lock);
+            mapbatch_free(b);
+            return NULL;
+        }
+        b->nthreads = k + 1;
+    }
+
+    return b;
+}
+
+void mapbatch_free (MapBatch *b) {
+    int k;
+
+    if(!b) {
+        return;
+    }
+
+    pthread_mutex_lock(&b->lock);
+    b->quit = TRUE;
+    pthread_cond_broadcast(&b->start);
+    pthread_mutex_unlock(&b->lock);
+
+    for(k=0; k < b->nthreads; k++) {
+        pthread_join(b->threads[k], NULL);
+        map_workspaceFree(b->workers[k].ws);
+        pthread_mutex_destroy(&b->workers[k].lock);
+    }
+
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->start);
+    pthread_cond_destroy(&b->done);
+    free(b->threads);
+    free(b->workers);
+    free(b);
+}
+
+int mapbatch_getNthreads (const MapBatch *b) {
+    if(!b) {
+        return 0;
+    }
+
+    return b->nthreads;
+}
+
+Status mapbatch_run (MapBatch *b, MapQuery *q, size_t n, P_map_search search) {
+    size_t block, extra, lo;
+    int k;
+
+    if(!b || (n > 0 && !q) || !search) {
+        return ERROR;
+    }
+
+    if(n == 0) {
+        return OK;
+    }
+
+    //un bloque contiguo por hilo; los hilos estan parados, no hace falta su cerrojo
+    block = n / b->nthreads;
+    extra = n % b->nthreads;
+    for(k=0, lo=0; k < b->nthreads; k++) {
+        b->workers[k].lo = lo;
+        lo += block + ((size_t) k < extra ? 1 : 0);
+        b->workers[k].hi = lo;
+    }
+
+    pthread_mutex_lock(&b->lock);
+    b->q = q;
+    b->search = search;
+    b->running = b->nthreads;
+    b->round++;
+    pthread_cond_broadcast(&b->start);
+    while(b->running > 0) {
+        pthread_cond_wait(&b->done, &b->lock);
+    }
+    pthread_mutex_unlock(&b->lock);
+
+    return OK;
+}
+
+void mapbatch_freePaths (MapQuery *q, size_t n) {
+    size_t i;
+
+    if(!q) {
+        return;
+    }
+
+    for(i=0; i < n; i++) {
+        free(q[i].path);
+        q[i].path = NULL;
+        q[i].len = 0;
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file  mapbatch.h
+ * @brief Multi-threaded batch of path queries over one map
+ *
+ * @details A MapBatch owns a fixed pool of threads, each one with its
+ * own MapWorkspace, that answer many (source, destination) queries over
+ * the same map at the same time. The searches only read the map, so it
+ * is shared by all the threads; it must not be modified while a batch
+ * is running.
+ *
+ * The queries are split in one contiguous block per thread. A thread 
+ * that finishes its block steals half of what is left in the block of 
+ * another thread, so long and short queries end up balanced.
+ */
+
+#ifndef MAPBATCH_H
+#define MAPBATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "types.h"
+#include "map.h"
+
+typedef struct _MapBatch MapBatch;
+
+/**
+ * @brief Search used to answer the queries: map_bfsBetween, 
+ * map_astarBetween, map_astarBidirectionalBetween or map_jpsBetween
+ **/
+typedef Status (*P_map_search)(const Map *, MapWorkspace *, uint32_t, uint32_t, const uint32_t **, size_t *);
+
+/**
+ * @brief A path query and its result
+ **/
+typedef struct {
+    uint32_t src, dst; // indices of the first and the last cell
+    Status status; // result of the search: OK, END (unreachable) or ERROR
+    uint32_t *path; // cells of the path, allocated by mapbatch_run (NULL if status is not OK)
+    size_t len; // number of cells of the path
+} MapQuery;
+
+/**
+ * @brief Creates a batch engine with nthreads threads for a map.
+ *
+ * @param mp, Pointer to the map, it must outlive the engine
+ * @param nthreads, Number of threads; 0 for one per online processor
+ *
+ * @return The new engine or NULL in case of error
+ **/
+MapBatch * mapbatch_new (const Map *mp, int nthreads);
+
+/**
+ * @brief Stops the threads and frees a batch engine.
+ *
+ * @param b, Pointer to the engine
+ **/
+void mapbatch_free (MapBatch *b);
+
+/**
+ * @brief Returns the number of threads of a batch engine.
+ *
+ * @param b, Pointer to the engine
+ *
+ * @return The number of threads, 0 in case of error
+ **/
+int mapbatch_getNthreads (const MapBatch *b);
+
+/**
+ * @brief Answers a batch of queries with the threads of the engine.
+ *
+ * Returns when all the queries have been answered. The path of every
+ * query with status OK is stored in its own array, which the caller
+ * frees with mapbatch_freePaths (or free). An engine runs one batch at
+ * a time: mapbatch_run must not be called from two threads at once.
+ *
+ * @code
+ * MapBatch *b = mapbatch_new (mp, 0);
+ * mapbatch_run (b, queries, n, map_bfsBetween);
+ * // ... use queries[i].path ...
+ * mapbatch_freePaths (queries, n);
+ * mapbatch_free (b);
+ * @endcode
+ *
+ * @param b, Pointer to the engine
+ * @param q, Array of n queries, with src and dst set
+ * @param n, Number of queries
+ * @param search, Search to use
+ *
+ * @return OK, or ERROR in case of invalid parameters. The result of each
+ * query is in its status field.
+ **/
+Status mapbatch_run (MapBatch *b, MapQuery *q, size_t n, P_map_search search);
+
+/**
+ * @brief Frees the paths stored in a batch of queries.
+ *
+ * @param q, Array of n queries
+ * @param n, Number of queries
+ **/
+void mapbatch_freePaths (MapQuery *q, size_t n);
+
+#endif /* MAPBATCH_H */
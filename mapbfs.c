@@ -0,0 +1,359 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "mapbfs.h"
+
+/* Cambio de direccion: se pasa a bottom-up cuando la frontera supera
+   1/MAPBFS_ALPHA de las celdas sin visitar y se vuelve a top-down cuando
+   baja de 1/MAPBFS_BETA de las celdas del mapa */
+#ifndef MAPBFS_ALPHA
+#define MAPBFS_ALPHA 14
+#endif
+#ifndef MAPBFS_BETA
+#define MAPBFS_BETA 24
+#endif
+/* Celdas de la frontera que toma un hilo cada vez en los pasos top-down */
+#define MAPBFS_CHUNK 1024
+
+/* Acceso al bitset de visitados */
+#define BIT_GET(bs, i) (((bs)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BIT_SET(bs, i) ((bs)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+
+typedef struct _MapBfsShared MapBfsShared;
+
+typedef struct {
+    MapBfsShared *sh;
+    int id;
+    uint32_t *buf; // celdas que este hilo ha anadido al siguiente nivel
+    size_t size, cap;
+    size_t offset; // posicion de buf dentro de la frontera siguiente
+    size_t w0, w1; // palabras de los bitsets que le tocan: celdas [64*w0, 64*w1)
+} MapBfsThread;
+
+struct _MapBfsShared {
+    const Map *mp;
+    uint32_t src;
+    uint32_t *dist;
+    size_t n, words;
+    long off[4]; // desplazamiento del indice hacia RIGHT, UP, LEFT, DOWN
+    int nthreads;
+    uint64_t *visited; // celdas ya alcanzadas
+    uint64_t *front_bm, *next_bm; // frontera actual y siguiente en los pasos bottom-up
+    uint32_t *front; // frontera actual en los pasos top-down
+    size_t front_size;
+    size_t cursor; // siguiente trozo de front por repartir (atomico)
+    size_t unvisited;
+    uint32_t level; // distancia de las celdas de la frontera
+    Bool bottom_up, was_bottom_up, done, failed;
+    pthread_barrier_t barrier;
+    pthread_mutex_t lock; // protege gate
+    pthread_cond_t gate_cond;
+    int gate; // 0 mientras se crean los hilos, 1 para empezar, -1 si hay que abandonar
+    MapBfsThread *threads;
+};
+
+/* Comprueba los parametros comunes de las dos BFS */
+static Status _mapbfs_check (const Map *mp, uint32_t src, const uint32_t *dist) {
+    MapCell cell;
+
+    if(!mp || !dist || map_getCellByIndex(mp, src, &cell) == ERROR || cell.symbol == BARRIER) {
+        return ERROR;
+    }
+
+    return OK;
+}
+
+Status mapbfs_distances (const Map *mp, uint32_t src, uint32_t *dist) {
+    if(_mapbfs_check(mp, src, dist) == ERROR) {
+        return ERROR;
+    }
+
+    return map_bfsDistances(mp, &src, 1, dist);
+}
+
+/* Anade v a la lista local del hilo */
+static void _mapbfs_push (MapBfsThread *t, uint32_t v) {
+    uint32_t *aux;
+    size_t cap;
+
+    if(t->size == t->cap) {
+        cap = t->cap ? 2 * t->cap : MAPBFS_CHUNK;
+        aux = (uint32_t*) realloc(t->buf, cap * sizeof(uint32_t));
+        if(!aux) {
+            //el resultado ya no vale, pero hay que seguir llegando a las barreras
+            __atomic_store_n(&t->sh->failed, TRUE, __ATOMIC_RELAXED);
+            return;
+        }
+        t->buf = aux;
+        t->cap = cap;
+    }
+    t->buf[t->size++] = v;
+}
+
+/* Paso top-down: cada hilo expande trozos de la frontera y reclama las celdas con un test-and-set atomico */
+static void _mapbfs_topDown (MapBfsThread *t) {
+    MapBfsShared *sh = t->sh;
+    size_t start, end, k;
+    uint32_t u, v;
+    uint64_t bit;
+    uint8_t m;
+
+    while((start = __atomic_fetch_add(&sh->cursor, MAPBFS_CHUNK, __ATOMIC_RELAXED)) < sh->front_size) {
+        end = start + MAPBFS_CHUNK < sh->front_size ? start + MAPBFS_CHUNK : sh->front_size;
+        for(k=start; k < end; k++) {
+            u = sh->front[k];
+            for(m = map_getNeighboorMask(sh->mp, u); m; m &= (uint8_t)(m - 1)) {
+                v = (uint32_t)((long) u + sh->off[__builtin_ctz(m)]);
+                bit = (uint64_t)1 << (v & 63);
+                if(__atomic_load_n(&sh->visited[v >> 6], __ATOMIC_RELAXED) & bit) {
+                    continue;
+                }
+                if(__atomic_fetch_or(&sh->visited[v >> 6], bit, __ATOMIC_RELAXED) & bit) {
+                    continue;
+                }
+                sh->dist[v] = sh->level + 1;
+                _mapbfs_push(t, v);
+            }
+        }
+    }
+}
+
+/* Paso bottom-up: cada celda sin visitar del rango del hilo busca un vecino en la frontera */
+static void _mapbfs_bottomUp (MapBfsThread *t) {
+    MapBfsShared *sh = t->sh;
+    size_t w;
+    uint64_t word;
+    uint32_t u, v;
+    uint8_t m;
+    int pos;
+
+    for(w=t->w0; w < t->w1; w++) {
+        word = ~sh->visited[w];
+        if((w + 1) * 64 > sh->n) {
+            word &= ((uint64_t)1 << (sh->n - w * 64)) - 1;
+        }
+        for(; word; word &= word - 1) {
+            v = (uint32_t)(w * 64 + __builtin_ctzll(word));
+            for(m = map_getNeighboorMask(sh->mp, v); m; m &= (uint8_t)(m - 1)) {
+                pos = __builtin_ctz(m);
+                u = (uint32_t)((long) v + sh->off[pos]);
+                //la mascara de u dice si v es transitable (la direccion opuesta es pos ^ 2)
+                if(BIT_GET(sh->front_bm, u) && (map_getNeighboorMask(sh->mp, u) & MAP_MASK(pos ^ 2))) {
+                    BIT_SET(sh->visited, v);
+                    BIT_SET(sh->next_bm, v);
+                    sh->dist[v] = sh->level + 1;
+                    _mapbfs_push(t, v);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/* Decide, con todos los hilos parados, como sigue la busqueda */
+static void _mapbfs_nextLevel (MapBfsShared *sh) {
+    size_t total = 0;
+    uint64_t *aux;
+    int k;
+
+    for(k=0; k < sh->nthreads; k++) {
+        sh->threads[k].offset = total;
+        total += sh->threads[k].size;
+    }
+
+    sh->unvisited -= total;
+    sh->done = (total == 0 || sh->failed == TRUE) ? TRUE : FALSE;
+    sh->was_bottom_up = sh->bottom_up;
+    if(sh->bottom_up == FALSE) {
+        sh->bottom_up = total > sh->unvisited / MAPBFS_ALPHA ? TRUE : FALSE;
+    }
+    else {
+        sh->bottom_up = total < sh->n / MAPBFS_BETA ? FALSE : TRUE;
+    }
+
+    //de bottom-up a bottom-up la frontera nueva es el bitset que se acaba de llenar
+    if(sh->was_bottom_up == TRUE && sh->bottom_up == TRUE) {
+        aux = sh->front_bm;
+        sh->front_bm = sh->next_bm;
+        sh->next_bm = aux;
+    }
+
+    sh->front_size = total;
+    sh->cursor = 0;
+    sh->level++;
+}
+
+static void * _mapbfs_thread (void *arg) {
+    MapBfsThread *t = (MapBfsThread*) arg;
+    MapBfsShared *sh = t->sh;
+    size_t i, first = t->w0 * 64, last = t->w1 * 64 < sh->n ? t->w1 * 64 : sh->n;
+    int gate;
+
+    //no se empieza hasta saber que se han podido crear todos los hilos
+    pthread_mutex_lock(&sh->lock);
+    while(sh->gate == 0) {
+        pthread_cond_wait(&sh->gate_cond, &sh->lock);
+    }
+    gate = sh->gate;
+    pthread_mutex_unlock(&sh->lock);
+    if(gate < 0) {
+        return NULL;
+    }
+
+    //cada hilo inicializa su parte de dist y de los bitsets
+    for(i=first; i < last; i++) {
+        sh->dist[i] = MAP_NODIST;
+    }
+    memset(sh->visited + t->w0, 0, (t->w1 - t->w0) * sizeof(uint64_t));
+    pthread_barrier_wait(&sh->barrier);
+    if(t->id == 0) {
+        sh->dist[sh->src] = 0;
+        BIT_SET(sh->visited, sh->src);
+    }
+    pthread_barrier_wait(&sh->barrier);
+
+    for(;;) {
+        t->size = 0;
+        if(sh->bottom_up == TRUE) {
+            _mapbfs_bottomUp(t);
+        }
+        else {
+            _mapbfs_topDown(t);
+        }
+
+        pthread_barrier_wait(&sh->barrier);
+        if(t->id == 0) {
+            _mapbfs_nextLevel(sh);
+        }
+        pthread_barrier_wait(&sh->barrier);
+        if(sh->done == TRUE) {
+            break;
+        }
+
+        //frontera nueva: lista para top-down, bitset para bottom-up
+        if(sh->bottom_up == FALSE) {
+            //un hilo sin vecinos nuevos puede no haber reservado aun su lista
+            if(t->size > 0) {
+                memcpy(sh->front + t->offset, t->buf, t->size * sizeof(uint32_t));
+            }
+        }
+        else if(sh->was_bottom_up == TRUE) {
+            memset(sh->next_bm + t->w0, 0, (t->w1 - t->w0) * sizeof(uint64_t));
+        }
+        else {
+            memset(sh->front_bm + t->w0, 0, (t->w1 - t->w0) * sizeof(uint64_t));
+            memset(sh->next_bm + t->w0, 0, (t->w1 - t->w0) * sizeof(uint64_t));
+            pthread_barrier_wait(&sh->barrier);
+            for(i=0; i < t->size; i++) {
+                __atomic_fetch_or(&sh->front_bm[t->buf[i] >> 6], (uint64_t)1 << (t->buf[i] & 63), __ATOMIC_RELAXED);
+            }
+        }
+        pthread_barrier_wait(&sh->barrier);
+    }
+
+    return NULL;
+}
+
+Status mapbfs_parallel (const Map *mp, uint32_t src, uint32_t *dist, int nthreads) {
+    MapBfsShared sh;
+    pthread_t *tids;
+    Status st = OK;
+    long online;
+    int k, started = 0;
+
+    if(_mapbfs_check(mp, src, dist) == ERROR || nthreads < 0) {
+        return ERROR;
+    }
+
+    if(nthreads == 0) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = online > 0 ? (int) online : 1;
+    }
+
+    memset(&sh, 0, sizeof(sh));
+    sh.mp = mp;
+    sh.src = src;
+    sh.dist = dist;
+    sh.n = (size_t) map_getNrows(mp) * map_getNcols(mp);
+    sh.words = (sh.n + 63) / 64;
+    if((size_t) nthreads > sh.words) {
+        nthreads = (int) sh.words;
+    }
+    sh.nthreads = nthreads;
+    sh.off[RIGHT] = 1;
+    sh.off[UP] = -(long) map_getNcols(mp);
+    sh.off[LEFT] = -1;
+    sh.off[DOWN] = map_getNcols(mp);
+    sh.unvisited = sh.n - 1;
+    sh.bottom_up = FALSE;
+    sh.failed = FALSE;
+    sh.front_size = 1;
+
+    sh.visited = (uint64_t*) malloc(sh.words * sizeof(uint64_t));
+    sh.front_bm = (uint64_t*) malloc(sh.words * sizeof(uint64_t));
+    sh.next_bm = (uint64_t*) malloc(sh.words * sizeof(uint64_t));
+    sh.front = (uint32_t*) malloc(sh.n * sizeof(uint32_t));
+    sh.threads = (MapBfsThread*) calloc(nthreads, sizeof(MapBfsThread));
+    tids = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    if(!sh.visited || !sh.front_bm || !sh.next_bm || !sh.front || !sh.threads || !tids
+       || pthread_barrier_init(&sh.barrier, NULL, nthreads) != 0) {
+        free(sh.visited);
+        free(sh.front_bm);
+        free(sh.next_bm);
+        free(sh.front);
+        free(sh.threads);
+        free(tids);
+        return ERROR;
+    }
+    sh.front[0] = src;
+
+    for(k=0; k < nthreads; k++) {
+        sh.threads[k].sh = &sh;
+        sh.threads[k].id = k;
+        sh.threads[k].w0 = sh.words * k / nthreads;
+        sh.threads[k].w1 = sh.words * (k + 1) / nthreads;
+    }
+
+    pthread_mutex_init(&sh.lock, NULL);
+    pthread_cond_init(&sh.gate_cond, NULL);
+    sh.gate = 0;
+
+    //el hilo que llama hace de hilo 0; si no se pueden crear todos, la barrera no se abriria
+    for(k=1; k < nthreads; k++) {
+        if(pthread_create(&tids[k], NULL, _mapbfs_thread, &sh.threads[k]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    pthread_mutex_lock(&sh.lock);
+    sh.gate = started == nthreads - 1 ? 1 : -1;
+    pthread_cond_broadcast(&sh.gate_cond);
+    pthread_mutex_unlock(&sh.lock);
+
+    if(sh.gate > 0) {
+        _mapbfs_thread(&sh.threads[0]);
+    }
+    for(k=1; k <= started; k++) {
+        pthread_join(tids[k], NULL);
+    }
+    if(sh.gate < 0 || sh.failed == TRUE) {
+        st = ERROR;
+    }
+
+    pthread_barrier_destroy(&sh.barrier);
+    pthread_mutex_destroy(&sh.lock);
+    pthread_cond_destroy(&sh.gate_cond);
+    for(k=0; k < nthreads; k++) {
+        free(sh.threads[k].buf);
+    }
+    free(sh.visited);
+    free(sh.front_bm);
+    free(sh.next_bm);
+    free(sh.front);
+    free(sh.threads);
+    free(tids);
+
+    return st;
+}
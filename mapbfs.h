@@ -0,0 +1,50 @@
+/**
+ * @file  mapbfs.h
+ * @brief Breadth-first distances over the cells of a map
+ *
+ * @details Computes, for every cell of a map, the number of steps of 
+ * the shortest path from a source cell. mapbfs_distances is the plain
+ * serial BFS; mapbfs_parallel gives the same distances using several 
+ * threads for a single huge search: the BFS advances level by level,
+ * each thread expands part of the frontier into its own list and the 
+ * cells are claimed with an atomic test-and-set on a visited bitset.
+ * When the frontier gets large compared with the unvisited part of the
+ * map, the search switches to bottom-up steps, where every unvisited 
+ * cell looks for a neighboor in the frontier, and back to top-down 
+ * when the frontier shrinks (direction-optimising BFS).
+ */
+
+#ifndef MAPBFS_H
+#define MAPBFS_H
+
+#include <stdint.h>
+#include "types.h"
+#include "map.h"
+
+/**
+ * @brief Computes the distance from src to every cell of a map, with
+ * map_bfsDistances.
+ *
+ * @param mp, Pointer to the map
+ * @param src, Index of the source cell, which must not be a BARRIER
+ * @param dist, Array with one element per cell of the map, where the 
+ * distances are stored (MAP_NODIST for unreachable cells and barriers)
+ *
+ * @return OK, or ERROR in case of invalid parameters or not enough memory
+ **/
+Status mapbfs_distances (const Map *mp, uint32_t src, uint32_t *dist);
+
+/**
+ * @brief Computes the same distances as mapbfs_distances with several
+ * threads.
+ *
+ * @param mp, Pointer to the map, which must not change during the call
+ * @param src, Index of the source cell, which must not be a BARRIER
+ * @param dist, Array with one element per cell of the map
+ * @param nthreads, Number of threads; 0 for one per online processor
+ *
+ * @return OK, or ERROR in case of invalid parameters or not enough memory
+ **/
+Status mapbfs_parallel (const Map *mp, uint32_t src, uint32_t *dist, int nthreads);
+
+#endif /* MAPBFS_H */
@@ -0,0 +1,260 @@
+#include <stdlib.h>
+#include "mapplan.h"
+#include "heap.h"
+
+/* Distancia infinita (celda sin camino hasta la meta) */
+#define PLAN_INF MAP_NODIST
+
+struct _MapPlanner {
+    Map *mp;
+    size_t n; // numero de celdas del mapa
+    uint32_t ncols;
+    uint32_t src, dst; // celdas de salida y meta
+    uint32_t last; // salida cuando se sumo la ultima correccion a km
+    uint32_t km; // D* Lite: suma de las heuristicas entre las salidas sucesivas
+    uint32_t *g; // distancia a la meta de la ultima expansion de cada celda
+    uint32_t *rhs; // distancia a la meta segun los vecinos (1 + el menor g)
+    Heap *heap; // celdas localmente inconsistentes (g != rhs)
+    uint32_t *path; // ultimo camino devuelto
+    size_t expanded; // celdas expandidas por el ultimo mapplanner_path
+};
+
+/* Indica si se puede pasar por la celda i */
+static Bool _mapplanner_isOpen (const MapPlanner *pl, uint32_t i) {
+    MapCell cell;
+
+    if(map_getCellByIndex(pl->mp, i, &cell) == ERROR) {
+        return FALSE;
+    }
+
+    return (cell.symbol != BARRIER && cell.symbol != ERRORCHAR) ? TRUE : FALSE;
+}
+
+/* Distancia Manhattan entre las celdas a y b */
+static uint32_t _mapplanner_heuristic (const MapPlanner *pl, uint32_t a, uint32_t b) {
+    uint32_t ax = a % pl->ncols, ay = a / pl->ncols;
+    uint32_t bx = b % pl->ncols, by = b / pl->ncols;
+
+    return (ax > bx ? ax - bx : bx - ax) + (ay > by ? ay - by : by - ay);
+}
+
+/* Clave de D* Lite [min(g, rhs) + h + km; min(g, rhs)] empaquetada en 64 bits */
+static uint64_t _mapplanner_key (const MapPlanner *pl, uint32_t i) {
+    uint64_t m = pl->g[i] < pl->rhs[i] ? pl->g[i] : pl->rhs[i], k1;
+
+    if(m == PLAN_INF) {
+        return UINT64_MAX;
+    }
+
+    k1 = m + _mapplanner_heuristic(pl, pl->src, i) + pl->km;
+    if(k1 > UINT32_MAX) {
+        k1 = UINT32_MAX;
+    }
+
+    return (k1 << 32) | m;
+}
+
+/* Recalcula rhs de la celda i y la pone en la cola si queda inconsistente */
+static void _mapplanner_update (MapPlanner *pl, uint32_t i) {
+    uint32_t nb[4], best = PLAN_INF;
+    int k, n;
+
+    if(i == pl->dst) {
+        pl->rhs[i] = _mapplanner_isOpen(pl, i) == TRUE ? 0 : PLAN_INF;
+    }
+    else {
+        //las mascaras solo llevan a vecinos transitables, pero la de un muro no tiene por que ser 0
+        if(_mapplanner_isOpen(pl, i) == TRUE) {
+            n = map_getNeighboors(pl->mp, i, nb);
+            for(k=0; k < n; k++) {
+                if(pl->g[nb[k]] < best) {
+                    best = pl->g[nb[k]];
+                }
+            }
+        }
+        pl->rhs[i] = best == PLAN_INF ? PLAN_INF : best + 1;
+    }
+
+    if(pl->g[i] != pl->rhs[i]) {
+        heap_push(pl->heap, i, _mapplanner_key(pl, i));
+    }
+    else if(heap_contains(pl->heap, i) == TRUE) {
+        heap_remove(pl->heap, i);
+    }
+}
+
+/* La celda i ha cambiado: cambian sus aristas con los cuatro vecinos */
+static void _mapplanner_cellChanged (void *data, const Map *mp, uint32_t i) {
+    MapPlanner *pl = (MapPlanner*) data;
+    uint32_t x = i % pl->ncols;
+
+    _mapplanner_update(pl, i);
+    if(x + 1 < pl->ncols) {
+        _mapplanner_update(pl, i + 1);
+    }
+    if(x > 0) {
+        _mapplanner_update(pl, i - 1);
+    }
+    if(i >= pl->ncols) {
+        _mapplanner_update(pl, i - pl->ncols);
+    }
+    if((size_t) i + pl->ncols < pl->n) {
+        _mapplanner_update(pl, i + pl->ncols);
+    }
+    (void) mp;
+}
+
+/* Expande celdas hasta que la distancia de la salida es correcta */
+static void _mapplanner_compute (MapPlanner *pl) {
+    uint32_t i, nb[4];
+    uint64_t key;
+    int k, n;
+
+    pl->expanded = 0;
+    while(heap_isEmpty(pl->heap) == FALSE
+          && (heap_topKey(pl->heap) < _mapplanner_key(pl, pl->src) || pl->rhs[pl->src] != pl->g[pl->src])) {
+        key = heap_topKey(pl->heap);
+        i = heap_pop(pl->heap);
+
+        //la clave se calculo con un km anterior: vuelve con la actual
+        if(key < _mapplanner_key(pl, i)) {
+            heap_push(pl->heap, i, _mapplanner_key(pl, i));
+            continue;
+        }
+
+        pl->expanded++;
+        if(pl->g[i] > pl->rhs[i]) {
+            pl->g[i] = pl->rhs[i];
+        }
+        else {
+            pl->g[i] = PLAN_INF;
+            _mapplanner_update(pl, i);
+        }
+
+        //el rhs de los vecinos depende del g de i
+        n = map_getNeighboors(pl->mp, i, nb);
+        for(k=0; k < n; k++) {
+            _mapplanner_update(pl, nb[k]);
+        }
+    }
+}
+
+MapPlanner * mapplanner_new (Map *mp, uint32_t src, uint32_t dst) {
+    MapPlanner *pl;
+    size_t n, i;
+
+    n = mp ? (size_t) map_getNrows(mp) * map_getNcols(mp) : 0;
+    if(!mp || src >= n || dst >= n) {
+        return NULL;
+    }
+
+    pl = (MapPlanner*) calloc(1, sizeof(MapPlanner));
+    if(!pl) {
+        return NULL;
+    }
+
+    pl->mp = mp;
+    pl->n = n;
+    pl->ncols = (uint32_t) map_getNcols(mp);
+    pl->src = pl->last = src;
+    pl->dst = dst;
+    pl->g = (uint32_t*) malloc(n * sizeof(uint32_t));
+    pl->rhs = (uint32_t*) malloc(n * sizeof(uint32_t));
+    pl->path = (uint32_t*) malloc(n * sizeof(uint32_t));
+    pl->heap = heap_new(n);
+    if(!pl->g || !pl->rhs || !pl->path || !pl->heap || map_setCellListener(mp, _mapplanner_cellChanged, pl) == ERROR) {
+        free(pl->g);
+        free(pl->rhs);
+        free(pl->path);
+        heap_free(pl->heap);
+        free(pl);
+        return NULL;
+    }
+
+    for(i=0; i < n; i++) {
+        pl->g[i] = pl->rhs[i] = PLAN_INF;
+    }
+    _mapplanner_update(pl, dst);
+
+    return pl;
+}
+
+void mapplanner_free (MapPlanner *pl) {
+    if(!pl) {
+        return;
+    }
+
+    map_setCellListener(pl->mp, NULL, NULL);
+    free(pl->g);
+    free(pl->rhs);
+    free(pl->path);
+    heap_free(pl->heap);
+    free(pl);
+}
+
+Status mapplanner_setStart (MapPlanner *pl, uint32_t src) {
+    if(!pl || src >= pl->n) {
+        return ERROR;
+    }
+
+    //las claves de la cola no se recalculan: se corrigen al sacarlas
+    pl->km += _mapplanner_heuristic(pl, pl->last, src);
+    pl->last = src;
+    pl->src = src;
+
+    return OK;
+}
+
+Status mapplanner_path (MapPlanner *pl, const uint32_t **path, size_t *len) {
+    uint32_t i, best, nb[4];
+    size_t k;
+    int j, n;
+
+    if(!pl || !path || !len) {
+        return ERROR;
+    }
+
+    *path = NULL;
+    *len = 0;
+    _mapplanner_compute(pl);
+
+    if(pl->g[pl->src] == PLAN_INF || _mapplanner_isOpen(pl, pl->src) == FALSE) {
+        return END;
+    }
+
+    //cada paso va al vecino con menor g, que esta un paso mas cerca de la meta
+    i = pl->src;
+    for(k=0; ; k++) {
+        pl->path[k] = i;
+        if(i == pl->dst || k + 1 == pl->n) {
+            break;
+        }
+        n = map_getNeighboors(pl->mp, i, nb);
+        for(j=0, best=i; j < n; j++) {
+            if(pl->g[nb[j]] < pl->g[best]) {
+                best = nb[j];
+            }
+        }
+        if(best == i) {
+            break;
+        }
+        i = best;
+    }
+
+    if(i != pl->dst) {
+        return ERROR;
+    }
+
+    *path = pl->path;
+    *len = k + 1;
+
+    return OK;
+}
+
+size_t mapplanner_expanded (const MapPlanner *pl) {
+    if(!pl) {
+        return 0;
+    }
+
+    return pl->expanded;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file  mapplan.h
+ * @brief Incremental shortest path planner (D* Lite) over a map
+ *
+ * @details A MapPlanner keeps the state of a search between a start
+ * and a goal cell across the changes of the map. It searches backwards,
+ * from the goal, and is notified by map_setCellSymbol, point_setSymbol
+ * on a point of the map and map_insertPoint of every changed cell, so
+ * after a door opens or closes the next mapplanner_path only repairs
+ * the distances that the change has affected instead of searching
+ * again from scratch. The start can also move (an agent walking along
+ * the path) without losing the state.
+ */
+
+#ifndef MAPPLAN_H
+#define MAPPLAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "types.h"
+#include "map.h"
+
+typedef struct _MapPlanner MapPlanner;
+
+/**
+ * @brief Creates a planner between two cells of a map and registers it
+ * as the listener of the map (see map_setCellListener). No search is
+ * done until the first mapplanner_path.
+ *
+ * @param mp, Pointer to the map, which must outlive the planner
+ * @param src, Index of the start cell
+ * @param dst, Index of the goal cell
+ *
+ * @return The new planner, or NULL in case of invalid parameters, not
+ * enough memory or if the map already has a listener
+ */
+MapPlanner * mapplanner_new (Map *mp, uint32_t src, uint32_t dst);
+
+/**
+ * @brief Frees a planner and removes it as the listener of its map.
+ *
+ * @param pl, Pointer to the planner
+ */
+void mapplanner_free (MapPlanner *pl);
+
+/**
+ * @brief Moves the start cell, keeping the search state.
+ *
+ * @param pl, Pointer to the planner
+ * @param src, Index of the new start cell
+ *
+ * @return OK or ERROR in case of invalid parameters
+ */
+Status mapplanner_setStart (MapPlanner *pl, uint32_t src);
+
+/**
+ * @brief Finds the shortest path from the start to the goal, repairing
+ * the state left by the previous call with the cells changed since.
+ *
+ * @param pl, Pointer to the planner
+ * @param path, Where the address of the path is stored: its cells from
+ * the start to the goal, valid until the next call or mapplanner_free
+ * @param len, Where the number of cells of the path is stored
+ *
+ * @return OK if a path was found, END if the goal is not reachable,
+ * ERROR in case of error
+ */
+Status mapplanner_path (MapPlanner *pl, const uint32_t **path, size_t *len);
+
+/**
+ * @brief Returns the number of cells expanded by the last
+ * mapplanner_path: all the reachable ones the first time, only the
+ * affected ones after a small change.
+ *
+ * @param pl, Pointer to the planner
+ * @return the number of cells
+ */
+size_t mapplanner_expanded (const MapPlanner *pl);
+
+#endif /* MAPPLAN_H */
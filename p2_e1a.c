@@ -12,7 +12,7 @@ int main(int argc, char *argv[]) {
 
     Point **p, *origen;
     int i, j, n, contador=0, cmp;
-    double distance;
+    double *distance;
 
     n=atoi(argv[1]);
     if(n<=0) return 1;
@@ -39,16 +39,20 @@ int main(int argc, char *argv[]) {
         contador++;
     }
 
-    for(i=0; i<n; i++) {
-        if(point_euDistance(p[i], origen, &distance)==ERROR) {
-            memory_free(p, contador);
-            return 1;
-        }
+    //todas las distancias al origen de una vez
+    distance=(double*) malloc(n*sizeof(double));
+    if(!distance || point_euDistanceBatch(origen, (const Point * const *) p, n, distance)==ERROR) {
+        free(distance);
+        memory_free(p, contador);
+        return 1;
+    }
 
+    for(i=0; i<n; i++) {
         fprintf(stdout,  "Point p[%d]=", i);
         point_print(stdout, p[i]);
-        fprintf(stdout, " distance: %.6lf\n", distance);
+        fprintf(stdout, " distance: %.6lf\n", distance[i]);
     }
+    free(distance);
 
 
     for(i=0; i<n; i++) {
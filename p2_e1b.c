@@ -4,6 +4,7 @@
 #include <math.h>
 #include "stack_fDoble.h"
 #include "point.h"
+#include "stack_sort.h"
 
 #define MAX_RAND 11
 
@@ -25,8 +26,13 @@ int main(int argc, char *argv[]) {
 
     n = atoi(argv[1]);
 
-    *punto = (Point**) malloc(n * sizeof(Point*));
-    if(!*punto){
+    if(n <= 0) {
+        fprintf(stderr, "Introduzca un numero de puntos positivo\n");
+        return -1;
+    }
+
+    punto = (Point**) malloc(n * sizeof(Point*));
+    if(!punto){
         fprintf(stderr, "Error creando array de puntos\n");
         return -1;
     }
@@ -46,6 +52,10 @@ int main(int argc, char *argv[]) {
         if(!punto[i]) {
             fprintf(stderr, "Error creando punto %d\n", i+1);
 
+            while(i > 0) {
+                point_free(punto[--i]);
+            }
+            free(punto);
             point_free(origen);
             return -1;
         }
@@ -53,9 +63,9 @@ int main(int argc, char *argv[]) {
 
     /* Muestra los puntos y sus distancias */
     for(i=0; i < n; i++) {
-        distancia = point_euDistance(origen, punto[i], &distancia);
+        point_euDistance(origen, punto[i], &distancia);
 
-        fprintf(stdout, "Point p[%d]=");
+        fprintf(stdout, "Point p[%d]=", i);
         point_print(stdout, punto[i]);
         fprintf(stdout, " distance: %lf\n", distancia);
     }
@@ -80,6 +90,13 @@ int main(int argc, char *argv[]) {
     p_ordenada = stack_orderPoints(p_original);
     if(!p_ordenada) {
         fprintf(stderr, "Error ordenando pila\n");
+        for(i = 0; i < n; i++) {
+            point_free(punto[i]);
+        }
+        free(punto);
+        point_free(origen);
+        stack_free(p_original);
+        return -1;
     }
 
     /* Muestra los puntos ordenados de la pila */
@@ -102,10 +119,10 @@ int main(int argc, char *argv[]) {
     return 0;
 }
 
+/* Devuelve una pila nueva con los puntos de sin ordenados por su 
+   distancia al origen (el mas lejano en la cima); sin queda vacia */
 Stack *stack_orderPoints(Stack *sin) {
     Stack *s_aux;
-    Point *p_aux1, *p_aux2;
-    int dist;
 
     s_aux = stack_init();
     if(!s_aux) {
@@ -113,28 +130,16 @@ Stack *stack_orderPoints(Stack *sin) {
     }
 
     while(stack_isEmpty(sin) == FALSE) {
-        p_aux1 = (Point*) stack_pop(sin);
-        if(!p_aux1) {
-            return NULL;
-        }
-
-        if(point_euDistance(p_aux1, stack_top(sin), dist) == ERROR) {
+        if(stack_push(s_aux, stack_pop(sin)) == ERROR) {
+            stack_free(s_aux);
             return NULL;
         }
-        while(stack_isEmpty(s_aux) == FALSE && dist == MENOR) {
-            p_aux2 = (Point*) stack_pop(s_aux);
-            if(!p_aux2) {
-                return NULL;
-            }
-
-            if(stack_push(sin, p_aux2) == ERROR) {
-                return NULL;
-            }
-        }
+    }
 
-        if(stack_push(s_aux, p_aux1) == ERROR) {
-            return NULL;
-        }
+    //O(n log n) sobre un array en lugar de ir y volver entre dos pilas
+    if(stack_sort(s_aux, point_cmpEuDistance) == ERROR) {
+        stack_free(s_aux);
+        return NULL;
     }
 
     return s_aux;
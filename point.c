@@ -1,12 +1,15 @@
 
 
-#include "point.h"
+#include "point_inline.h"
 
-struct _Point {
-    int x, y;
-    char symbol;
-    Bool visited; // for DFS
-};
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Puntos que point_euDistanceBatch copia de una vez a arrays x, y */
+#define POINT_BATCH_CHUNK 256
 
 /**
  * @brief Constructor. Initialize a point.
@@ -34,6 +37,9 @@ Point * point_new (int x, int y, char symbol) {
     if(!new_point)
         return NULL;
 
+    new_point->visited = FALSE;
+    new_point->owner = NULL;
+
     if(point_setCoordinateX(new_point, x)==ERROR || point_setCoordinateY(new_point, y)==ERROR || point_setSymbol(new_point, symbol)==ERROR) {
         point_free(new_point);
         return NULL;
@@ -57,6 +63,96 @@ void point_free (Point *p) {
 }
 
 
+/**
+ * @brief Constructor. Allocates a block of n points in a single allocation.
+ *
+ * @param n Number of points of the block, must be greater than zero
+ * 
+ * @return Return the block (its first point) if it was done correctly, 
+ * otherwise return NULL.
+*/
+Point * point_newBlock (size_t n) {
+    Point *block;
+    size_t i;
+
+    if(n == 0 || n > (size_t)-1 / sizeof(Point)) {
+        return NULL;
+    }
+
+    block = (Point*) malloc(n * sizeof(Point));
+    if(!block) {
+        return NULL;
+    }
+
+    for(i=0; i < n; i++) {
+        block[i].x = 0;
+        block[i].y = 0;
+        block[i].symbol = SPACE;
+        block[i].visited = FALSE;
+        block[i].owner = NULL;
+    }
+
+    return block;
+}
+
+/**
+ * @brief Gets the i-th point of a block created with point_newBlock.
+ *
+ * @param block Block of points
+ * @param i Position of the point inside the block
+ *
+ * @return Returns the point, or NULL in case of error.
+ */
+Point * point_getBlockPoint (Point *block, size_t i) {
+    if(!block) {
+        return NULL;
+    }
+
+    return block + i;
+}
+
+/**
+ * @brief Initializes n consecutive points of a block as a row of a map.
+ *
+ * @param row First point to initialize
+ * @param y y coordinate of all the points
+ * @param symbols Symbol of each point, the x coordinates are 0..n-1
+ * @param n Number of points
+ * @param owner Owner of the points, or NULL
+ *
+ * @return Returns OK or ERROR in case of error 
+ */
+Status point_fillBlockRow (Point *row, int y, const char *symbols, size_t n, const PointOwner *owner) {
+    size_t i;
+
+    if(!row || !symbols || y < 0 || n > (size_t)__INT_MAX__) {
+        return ERROR;
+    }
+
+    for(i=0; i < n; i++) {
+        if(symbols[i] == ERRORCHAR) {
+            return ERROR;
+        }
+        row[i].x = (int) i;
+        row[i].y = y;
+        row[i].symbol = symbols[i];
+        row[i].visited = FALSE;
+        row[i].owner = owner;
+    }
+
+    return OK;
+}
+
+/**
+ * @brief Destructor. Frees a block created with point_newBlock.
+ *
+ * @param block Block to free
+ */
+void point_freeBlock (Point *block) {
+    free(block);
+}
+
+
 /**
  * @brief Gets the x coordinate of a given point.
  *
@@ -155,12 +251,63 @@ Status point_setSymbol (Point *p, char c) {
         return ERROR;
     }
     p->symbol=c;
+    if(p->owner) {
+        p->owner->changed(p->owner->data, p);
+    }
     
     return OK;
 }
 
-Bool point_getVisited (const Point *p); // DFS (P2)
-Status point_setVisited (Point *p, Bool bol);    // DFS (P2)
+
+/**
+ * @brief Sets the owner notified by point_setSymbol.
+ *
+ * @param p Point pointer
+ * @param owner New owner, NULL to remove the current one
+ *
+ * @return Returns OK or ERROR in case of error 
+ */
+Status point_setOwner (Point *p, const PointOwner *owner) {
+    if(!p) {
+        return ERROR;
+    }
+    p->owner = owner;
+
+    return OK;
+}
+
+/**
+ * @brief Gets the visited flag of a given point.
+ *
+ * @param Point pointer
+ *
+ * @return Returns the visited flag of a given point, or FALSE in 
+ * case of error.
+ */
+Bool point_getVisited (const Point *p) {
+    if(!p) {
+        return FALSE;
+    }
+    return p->visited;
+}
+
+
+/**
+ * @brief Modifies the visited flag of a given point.
+ *
+ * @param p Point pointer
+ * @param bol New visited flag
+ *
+ * @return Returns OK or ERROR in case of error 
+ */
+Status point_setVisited (Point *p, Bool bol) {
+    if(!p || (bol != TRUE && bol != FALSE)) {
+        return ERROR;
+    }
+    p->visited = bol;
+    
+    return OK;
+}
 
 
 /**
@@ -251,6 +398,129 @@ int point_print (FILE *pf, const void *p) {
     return fprintf(pf, "[(%d, %d): %c]", _p->x, _p->y, _p->symbol /*visited*/);
 }
 
+/**
+ * @brief Writes n in decimal in dst, without printf and without '\0'.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param n Number
+ *
+ * @return Returns the number of characters written.
+ */
+size_t point_renderInt (char *dst, int64_t n) {
+    char tmp[20];
+    size_t len = 0, i = 0;
+    uint64_t u;
+
+    if(n < 0) {
+        dst[len++] = '-';
+        u = 0u - (uint64_t) n;
+    }
+    else {
+        u = (uint64_t) n;
+    }
+
+    do {
+        tmp[i++] = (char)('0' + u % 10);
+        u /= 10;
+    } while(u > 0);
+
+    while(i > 0) {
+        dst[len++] = tmp[--i];
+    }
+
+    return len;
+}
+
+/**
+ * @brief Writes in dst the text of a point with the format of point_print.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param x, y Coordinates
+ * @param symbol Symbol
+ *
+ * @return Returns the number of characters written.
+ */
+size_t point_renderCoords (char *dst, int x, int y, char symbol) {
+    size_t len = 0;
+
+    dst[len++] = '[';
+    dst[len++] = '(';
+    len += point_renderInt(dst + len, x);
+    dst[len++] = ',';
+    dst[len++] = ' ';
+    len += point_renderInt(dst + len, y);
+    dst[len++] = ')';
+    dst[len++] = ':';
+    dst[len++] = ' ';
+    dst[len++] = symbol;
+    dst[len++] = ']';
+
+    return len;
+}
+
+/**
+ * @brief Writes in dst the text of a point, as point_renderCoords.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param p Point to render
+ *
+ * @return Returns the number of characters written, 0 in case of error.
+ */
+size_t point_render (char *dst, const Point *p) {
+    if(!dst || !p) {
+        return 0;
+    }
+
+    return point_renderCoords(dst, p->x, p->y, p->symbol);
+}
+
+/** 
+ * @brief Prints in pf a batch of points using a caller-supplied buffer.
+ *
+ * @param pf File descriptor
+ * @param pts Points to be printed
+ * @param n Number of points
+ * @param buf Buffer
+ * @param size Size of the buffer, at least POINT_RENDER_MAX
+ *
+ * @return Returns the number of characters that have been written 
+ * successfully. If there have been errors returns -1.
+ */
+int point_printBatch (FILE *pf, const Point * const *pts, size_t n, char *buf, size_t size) {
+    size_t i, used = 0, total = 0;
+
+    if(!pf || (!pts && n > 0) || !buf || size < POINT_RENDER_MAX) {
+        return -1;
+    }
+
+    for(i=0; i < n; i++) {
+        if(!pts[i]) {
+            return -1;
+        }
+        if(size - used < POINT_RENDER_MAX) {
+            if(fwrite(buf, 1, used, pf) != used) {
+                return -1;
+            }
+            total += used;
+            used = 0;
+        }
+        used += point_renderCoords(buf + used, pts[i]->x, pts[i]->y, pts[i]->symbol);
+    }
+
+    if(used > 0 && fwrite(buf, 1, used, pf) != used) {
+        return -1;
+    }
+
+    return (int)(total + used);
+}
+
+/* Cuadrado de la distancia de p a (x0, y0), en 64 bits para que no desborde */
+static int64_t _point_sqDistance (const Point *p, int x0, int y0) {
+    int64_t dx = (int64_t) p->x - x0, dy = (int64_t) p->y - y0;
+
+    return dx*dx + dy*dy;
+}
+
 /**
 * @brief Calculate the euclidean distance betweeen two points.
 *
@@ -280,12 +550,11 @@ distance) {
 
     if(!p1 || !p2 || !distance) return ERROR;
 
-    x1=point_getCoordinateX(p1);
-    x2=point_getCoordinateX(p2);
-    y1=point_getCoordinateY(p1);
-    y2=point_getCoordinateY(p2);
-
-    if(x1==__INT_MAX__ || x2==__INT_MAX__ || y1==__INT_MAX__ || y2==__INT_MAX__) return ERROR;
+    //los punteros ya estan comprobados, no hace falta mirar INT_MAX
+    x1=point_getCoordinateXUnchecked(p1);
+    x2=point_getCoordinateXUnchecked(p2);
+    y1=point_getCoordinateYUnchecked(p1);
+    y2=point_getCoordinateYUnchecked(p2);
 
     x=x2-x1;
     y=y2-y1;
@@ -311,34 +580,234 @@ zero if
 INT_MIN.
 */
 int point_cmpEuDistance (const void *p1, const void *p2) {
-    double eud1, eud2, cmpeud;
-    Point *p0=NULL;
-
-    p0=point_new(0, 0, BARRIER);
+    int64_t d1, d2;
 
     if(!p1 || !p2) return INT_MIN;
 
-    if(point_euDistance(p0, p1, &eud1)==ERROR) {
-        point_free(p0);
-        return INT_MIN;
+    //se comparan los cuadrados de las distancias, enteros y exactos
+    d1=_point_sqDistance(p1, 0, 0);
+    d2=_point_sqDistance(p2, 0, 0);
+
+    /*-1:primero menor que el segundo   0:iguales   1:primero mayor que el segundo*/
+    return (d1 > d2) - (d1 < d2);
+}
+
+/**
+* @brief Compares two points using their euclidean distances to the
+* point ref.
+*
+* @param ref Reference point.
+* @param p1,p2 Points to compare.
+*
+* @return It returns an integer less than, equal to, or greater than
+* zero if the euclidean distance of p1 to ref is found, respectively, 
+* to be less than, to match or be greater than the euclidean distance 
+* of p2. In case of error, returns INT_MIN.
+*/
+int point_cmpEuDistanceTo (const Point *ref, const void *p1, const void *p2) {
+    int64_t d1, d2;
+
+    if(!ref || !p1 || !p2) return INT_MIN;
+
+    d1=_point_sqDistance(p1, ref->x, ref->y);
+    d2=_point_sqDistance(p2, ref->x, ref->y);
+
+    return (d1 > d2) - (d1 < d2);
+}
+
+/* Distancias de (rx, ry) a los n puntos (xs[i], ys[i]), vectorizado si 
+   el compilador tiene AVX2 o SSE2 */
+static void _point_distanceKernel (int32_t rx, int32_t ry, const int32_t *xs, const int32_t *ys, size_t n, double *out) {
+    size_t i = 0;
+    double dx, dy;
+#if defined(__AVX2__)
+    __m256d vrx = _mm256_set1_pd(rx), vry = _mm256_set1_pd(ry), vx, vy;
+
+    for(; i + 4 <= n; i += 4) {
+        vx = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(xs + i))), vrx);
+        vy = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(ys + i))), vry);
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy))));
     }
+#elif defined(__SSE2__)
+    __m128d vrx = _mm_set1_pd(rx), vry = _mm_set1_pd(ry), vx, vy;
 
-    if(point_euDistance(p0, p2, &eud2)==ERROR) {
-        point_free(p0);
-        return INT_MIN;
+    for(; i + 2 <= n; i += 2) {
+        vx = _mm_sub_pd(_mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(xs + i))), vrx);
+        vy = _mm_sub_pd(_mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(ys + i))), vry);
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy))));
     }
+#endif
 
-    point_free(p0);
+    //resto (o todo si no hay SIMD)
+    for(; i < n; i++) {
+        dx = (double) xs[i] - rx;
+        dy = (double) ys[i] - ry;
+        out[i] = sqrt(dx*dx + dy*dy);
+    }
+}
 
-    /*-1:primero menor que el segundo   0:iguales   1:primero mayor que el segundo*/
-    cmpeud=eud2-eud1;
-    if(cmpeud==0) {
-        return 0;
+/**
+* @brief Calculates the euclidean distances from ref to a batch of points.
+*
+* @param ref Reference point
+* @param pts Array of n points
+* @param n Number of points
+* @param out Array where the n distances are stored
+*
+* @return Returns OK or ERROR in case of invalid parameters
+*/
+Status point_euDistanceBatch (const Point *ref, const Point * const *pts, size_t n, double *out) {
+    int32_t xs[POINT_BATCH_CHUNK], ys[POINT_BATCH_CHUNK];
+    size_t i, j, m;
+
+    if(!ref || (n > 0 && (!pts || !out))) return ERROR;
+
+    //se copian las coordenadas por bloques y se pasan al nucleo vectorial
+    for(i=0; i < n; i += m) {
+        m = n - i < POINT_BATCH_CHUNK ? n - i : POINT_BATCH_CHUNK;
+        for(j=0; j < m; j++) {
+            if(!pts[i + j]) return ERROR;
+            xs[j] = pts[i + j]->x;
+            ys[j] = pts[i + j]->y;
+        }
+        _point_distanceKernel(ref->x, ref->y, xs, ys, m, out + i);
     }
-    else if(cmpeud<0) {
-        return 1;
+
+    return OK;
+}
+
+/**
+* @brief Calculates the euclidean distances from (rx, ry) to a batch of
+* points stored as separate coordinate arrays.
+*
+* @param rx, ry Coordinates of the reference point
+* @param xs, ys Coordinates of the n points
+* @param n Number of points
+* @param out Array where the n distances are stored
+*
+* @return Returns OK or ERROR in case of invalid parameters
+*/
+Status point_euDistanceBatchSoA (int32_t rx, int32_t ry, const int32_t *xs, const int32_t *ys, size_t n, double *out) {
+    if(n > 0 && (!xs || !ys || !out)) return ERROR;
+
+    _point_distanceKernel(rx, ry, xs, ys, n, out);
+
+    return OK;
+}
+
+/**
+* @brief Calculates the squared euclidean distances from (rx, ry) to a
+* batch of points stored as separate coordinate arrays.
+*
+* @param rx, ry Coordinates of the reference point
+* @param xs, ys Coordinates of the n points
+* @param n Number of points
+* @param out Array where the n squared distances are stored
+*
+* @return Returns OK or ERROR in case of invalid parameters
+*/
+Status point_sqDistanceBatchSoA (int32_t rx, int32_t ry, const int32_t *xs, const int32_t *ys, size_t n, int64_t *out) {
+    size_t i;
+    int64_t dx, dy;
+
+    if(n > 0 && (!xs || !ys || !out)) return ERROR;
+
+    //bucle simple, sin dependencias: el compilador lo vectoriza con -O3
+    for(i=0; i < n; i++) {
+        dx = (int64_t) xs[i] - rx;
+        dy = (int64_t) ys[i] - ry;
+        out[i] = dx*dx + dy*dy;
     }
-    else {
-        return -1;
+
+    return OK;
+}
+
+/* Elemento del monticulo de point_nearestK */
+typedef struct {
+    int64_t key; // cuadrado de la distancia a ref
+    const Point *p;
+} PointHeapItem;
+
+/* Hunde el elemento i en el monticulo de maximos h de tamano n */
+static void _point_heapDown (PointHeapItem *h, size_t i, size_t n) {
+    size_t child;
+    PointHeapItem aux = h[i];
+
+    while((child = 2*i + 1) < n) {
+        if(child + 1 < n && h[child + 1].key > h[child].key) {
+            child++;
+        }
+        if(aux.key >= h[child].key) {
+            break;
+        }
+        h[i] = h[child];
+        i = child;
+    }
+    h[i] = aux;
+}
+
+/**
+* @brief Finds the k points of an array closest to ref.
+*
+* @param ref Reference point
+* @param pts Array of n points
+* @param n Number of points
+* @param k Number of points wanted
+* @param out Array with room for k points, where the closest ones are 
+* stored in increasing order of distance
+*
+* @return Returns the number of points stored, min(n, k), or -1 in 
+* case of error.
+*/
+int point_nearestK (const Point *ref, const Point * const *pts, size_t n, size_t k, const Point **out) {
+    PointHeapItem *h, aux;
+    size_t i, j, size = 0;
+    int64_t dx, dy, key;
+
+    if(!ref || (n > 0 && !pts) || (k > 0 && !out) || k > (size_t)__INT_MAX__) return -1;
+
+    if(k > n) k = n;
+    if(k == 0) return 0;
+
+    h = (PointHeapItem*) malloc(k * sizeof(PointHeapItem));
+    if(!h) return -1;
+
+    //monticulo de maximos con los k mejores vistos: la cima es el peor
+    for(i=0; i < n; i++) {
+        if(!pts[i]) {
+            free(h);
+            return -1;
+        }
+        dx = (int64_t) pts[i]->x - ref->x;
+        dy = (int64_t) pts[i]->y - ref->y;
+        key = dx*dx + dy*dy;
+
+        if(size < k) {
+            h[size].key = key;
+            h[size].p = pts[i];
+            size++;
+            if(size == k) {
+                for(j=k/2; j > 0; j--) {
+                    _point_heapDown(h, j - 1, k);
+                }
+            }
+        }
+        else if(key < h[0].key) {
+            h[0].key = key;
+            h[0].p = pts[i];
+            _point_heapDown(h, 0, k);
+        }
+    }
+
+    //se sacan de mayor a menor para dejarlos ordenados
+    for(i=k; i > 0; i--) {
+        aux = h[0];
+        h[0] = h[i - 1];
+        h[i - 1] = aux;
+        _point_heapDown(h, 0, i - 1);
+        out[i - 1] = aux.p;
     }
-}
\ No newline at end of file
+
+    free(h);
+    return (int) k;
+}
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdint.h>
 
 #include "types.h" 
 
@@ -20,10 +21,23 @@
 #define BARRIER '+'
 #define SPACE '.'
 
+/* Maximum number of characters written by point_render, point_renderCoords and point_renderInt */
+#define POINT_RENDER_MAX 32
+
 /* START [_Point] */
 typedef struct _Point Point;
 /* END [_Point] */
 
+/**
+ * @brief Owner of a point, notified by point_setSymbol after the symbol 
+ * of the point changes. A map owns its points this way, so that its 
+ * neighboor masks and caches follow the changes of their symbols.
+ **/
+typedef struct {
+    void (*changed) (void *data, const Point *p); // called after the change
+    void *data; // first argument of changed
+} PointOwner;
+
 
 
 /**
@@ -57,6 +71,68 @@ Point * point_new (int x, int y, char symbol);
 void point_free (Point *p);
 
 
+/**
+ * @brief Constructor. Allocates a block of n points in a single allocation.
+ *
+ * All the points of the block are initialized at (0, 0) with symbol
+ * SPACE and not visited. Points of a block must never be released with 
+ * point_free, only the whole block at once with point_freeBlock.
+ *
+ * @code
+ * // Example of use
+ * Point *block, *p;
+ * block = point_newBlock (nrows * ncols);
+ * p = point_getBlockPoint (block, 3);
+ * point_setSymbol (p, BARRIER);
+ * // .... additional code ....
+ * point_freeBlock (block);
+ * @endcode
+ *
+ * @param n Number of points of the block, must be greater than zero
+ * 
+ * @return Return the block (its first point) if it was done correctly, 
+ * otherwise return NULL.
+*/
+Point * point_newBlock (size_t n);
+
+/**
+ * @brief Gets the i-th point of a block created with point_newBlock.
+ *
+ * @param block Block of points
+ * @param i Position of the point inside the block
+ *
+ * @return Returns the point, or NULL in case of error. The index is 
+ * not checked against the block size.
+ */
+Point * point_getBlockPoint (Point *block, size_t i);
+
+/**
+ * @brief Initializes n consecutive points of a block as a row of a map.
+ *
+ * The point i gets the coordinates (i, y), the symbol symbols[i] and 
+ * the given owner, and is marked as not visited. The owner is not 
+ * notified of these symbols.
+ *
+ * @param row First point to initialize
+ * @param y y coordinate of all the points
+ * @param symbols Symbol of each point
+ * @param n Number of points
+ * @param owner Owner of the points, or NULL
+ *
+ * @return Returns OK or ERROR in case of error (an ERRORCHAR symbol
+ * included)
+ */
+Status point_fillBlockRow (Point *row, int y, const char *symbols, size_t n, const PointOwner *owner);
+
+/**
+ * @brief Destructor. Frees a block created with point_newBlock and 
+ * all its points.
+ *
+ * @param block Block to free
+ */
+void point_freeBlock (Point *block);
+
+
 /**
  * @brief Gets the x coordinate of a given point.
  *
@@ -115,6 +191,9 @@ Status point_setCoordinateY (Point *p, int y) ;
 /**
  * @brief Modifies the symbol of a given point.
  *
+ * If the point has an owner (the points of a map do), the owner is 
+ * notified once the symbol has changed.
+ *
  * @param p Point pointer
  * @param c New symbol, must be a valid symbol
  *
@@ -122,7 +201,36 @@ Status point_setCoordinateY (Point *p, int y) ;
  */
 Status  point_setSymbol (Point *p, char c) ;
 
+/**
+ * @brief Sets the owner notified by point_setSymbol.
+ *
+ * @param p Point pointer
+ * @param owner New owner, NULL to remove the current one. It has to 
+ * outlive the point, or be removed first.
+ *
+ * @return Returns OK or ERROR in case of error 
+ */
+Status point_setOwner (Point *p, const PointOwner *owner);
+
+/**
+ * @brief Gets the visited flag of a given point.
+ *
+ * @param Point pointer
+ *
+ * @return Returns the visited flag of a given point, or FALSE in 
+ * case of error.
+ */
 Bool point_getVisited (const Point *p); // DFS (P2)
+
+
+/**
+ * @brief Modifies the visited flag of a given point.
+ *
+ * @param p Point pointer
+ * @param bol New visited flag, TRUE or FALSE
+ *
+ * @return Returns OK or ERROR in case of error 
+ */
 Status point_setVisited (Point *p, Bool bol);    // DFS (P2)
 
 
@@ -181,6 +289,64 @@ Bool point_equal (const void *p1, const void *p2);
 int point_print (FILE *pf, const void *p); 
 
 
+/**
+ * @brief Writes n in decimal in dst, without printf and without the 
+ * final '\0', as point_renderCoords writes the coordinates.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param n Number
+ *
+ * @return Returns the number of characters written.
+ */
+size_t point_renderInt (char *dst, int64_t n);
+
+/**
+ * @brief Writes in dst the text of a point with the format of point_print, 
+ * [(x, y): symbol], without printf and without the final '\0'.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param x, y Coordinates
+ * @param symbol Symbol
+ *
+ * @return Returns the number of characters written.
+ */
+size_t point_renderCoords (char *dst, int x, int y, char symbol);
+
+/**
+ * @brief Writes in dst the text of a point, as point_renderCoords.
+ *
+ * @param dst Buffer with room for POINT_RENDER_MAX characters
+ * @param p Point to render
+ *
+ * @return Returns the number of characters written, 0 in case of error.
+ */
+size_t point_render (char *dst, const Point *p);
+
+/** 
+ * @brief Prints in pf a batch of points using a caller-supplied buffer.
+ * 
+ * The points are rendered one after another with the format of 
+ * point_print into buf, which is written with a single fwrite each time
+ * it fills up (just once if it is big enough for the whole batch).
+ * The buffer can be reused between calls.
+ *
+ * @code
+ * char buf[1 << 16];
+ * point_printBatch (stdout, (const Point * const *) points, n, buf, sizeof (buf));
+ * @endcode
+ *
+ * @param pf File descriptor
+ * @param pts Points to be printed
+ * @param n Number of points
+ * @param buf Buffer
+ * @param size Size of the buffer, at least POINT_RENDER_MAX
+ *
+ * @return Returns the number of characters that have been written 
+ * successfully. If there have been errors returns -1.
+ */
+int point_printBatch (FILE *pf, const Point * const *pts, size_t n, char *buf, size_t size);
+
+
 //////////////////////////   P2 
 
 /* START [_EUC] */
@@ -212,6 +378,8 @@ Status point_euDistance (const Point *p1, const Point *p2, double *distance);
 /**
  * @brief Compares two points using their euclidean distances to the point (0,0).
  *
+ * The squared distances x*x + y*y are compared as 64-bit integers: 
+ * the result is exact and nothing is allocated.
  * 
  * @param p1,p2 Points to compare.
  *
@@ -222,6 +390,99 @@ Status point_euDistance (const Point *p1, const Point *p2, double *distance);
  */
 int point_cmpEuDistance (const void *p1, const void *p2); 
 
+/**
+ * @brief Compares two points using their euclidean distances to the point ref.
+ *
+ * As point_cmpEuDistance, the squared distances are compared as 64-bit
+ * integers, so the result is exact and nothing is allocated.
+ * 
+ * @param ref Reference point.
+ * @param p1,p2 Points to compare.
+ *
+ * @return It returns an integer less than, equal to, or greater than zero if
+ * the euclidean distance of p1 to ref is found, respectively, to be less 
+ * than, to match or be greater than the euclidean distance of p2. In case
+ * of error, returns INT_MIN. 
+ */
+int point_cmpEuDistanceTo (const Point *ref, const void *p1, const void *p2);
+
+/**
+ * @brief Calculates the euclidean distances from ref to a batch of points.
+ *
+ * The coordinates are copied in blocks to contiguous arrays and the 
+ * distances computed with AVX2 or SSE2 when the compiler targets them
+ * (scalar code otherwise).
+ *
+ * @code
+ * double *d = malloc (n * sizeof (double));
+ * point_euDistanceBatch (origin, (const Point * const *) points, n, d);
+ * @endcode
+ *
+ * @param ref Reference point
+ * @param pts Array of n points
+ * @param n Number of points
+ * @param out Array where the n distances are stored
+ *
+ * @return Returns OK or ERROR in case of invalid parameters
+ */
+Status point_euDistanceBatch (const Point *ref, const Point * const *pts, size_t n, double *out);
+
+/**
+ * @brief Calculates the euclidean distances from (rx, ry) to a batch of
+ * points stored as separate coordinate arrays (struct of arrays).
+ *
+ * Same kernel as point_euDistanceBatch, reading xs and ys directly.
+ *
+ * @param rx, ry Coordinates of the reference point
+ * @param xs, ys Coordinates of the n points
+ * @param n Number of points
+ * @param out Array where the n distances are stored
+ *
+ * @return Returns OK or ERROR in case of invalid parameters
+ */
+Status point_euDistanceBatchSoA (int32_t rx, int32_t ry, const int32_t *xs, const int32_t *ys, size_t n, double *out);
+
+/**
+ * @brief Calculates the squared euclidean distances from (rx, ry) to a 
+ * batch of points stored as separate coordinate arrays.
+ *
+ * The results are exact 64-bit integers, enough to order the points 
+ * as point_cmpEuDistance does.
+ *
+ * @param rx, ry Coordinates of the reference point
+ * @param xs, ys Coordinates of the n points
+ * @param n Number of points
+ * @param out Array where the n squared distances are stored
+ *
+ * @return Returns OK or ERROR in case of invalid parameters
+ */
+Status point_sqDistanceBatchSoA (int32_t rx, int32_t ry, const int32_t *xs, const int32_t *ys, size_t n, int64_t *out);
+
+/**
+ * @brief Finds the k points of an array closest to ref.
+ *
+ * Streams over the array keeping a max-heap with the k best points 
+ * seen (by exact squared distance, as point_cmpEuDistanceTo), so it 
+ * takes O(n log k) time and O(k) memory instead of sorting the whole 
+ * array.
+ *
+ * @code
+ * const Point *best[10];
+ * int m = point_nearestK (origin, (const Point * const *) points, n, 10, best);
+ * @endcode
+ *
+ * @param ref Reference point
+ * @param pts Array of n points
+ * @param n Number of points
+ * @param k Number of points wanted
+ * @param out Array with room for k points, where the closest ones are 
+ * stored in increasing order of distance
+ *
+ * @return Returns the number of points stored, min(n, k), or -1 in 
+ * case of error.
+ */
+int point_nearestK (const Point *ref, const Point * const *pts, size_t n, size_t k, const Point **out);
+
 /* END [_EUC] */
 
 
@@ -0,0 +1,78 @@
+/* 
+ * File:   point_inline.h
+ *
+ * Definition of the Point structure and inline accessors without checks,
+ * for the modules that want them expanded in their hot loops. They do 
+ * not check p, so they can only be used once p is known to be valid.
+ *
+ * point.c always includes this file; map.c only does when it is compiled
+ * with -DPOINT_FAST (make fast), otherwise Point stays opaque for it.
+ */
+
+#ifndef POINT_INLINE_H
+#define POINT_INLINE_H
+
+#include "point.h"
+
+struct _Point {
+    int x, y;
+    char symbol;
+    Bool visited; // for DFS
+    const PointOwner *owner; // notified by point_setSymbol (NULL if none)
+};
+
+/**
+ * @brief Gets the x coordinate of a valid point, without checks.
+ *
+ * @param p Point pointer, not NULL
+ *
+ * @return Returns the x coordinate
+ */
+static inline int point_getCoordinateXUnchecked (const Point *p) {
+    return p->x;
+}
+
+/**
+ * @brief Gets the y coordinate of a valid point, without checks.
+ *
+ * @param p Point pointer, not NULL
+ *
+ * @return Returns the y coordinate
+ */
+static inline int point_getCoordinateYUnchecked (const Point *p) {
+    return p->y;
+}
+
+/**
+ * @brief Gets the symbol of a valid point, without checks.
+ *
+ * @param p Point pointer, not NULL
+ *
+ * @return Returns the symbol
+ */
+static inline char point_getSymbolUnchecked (const Point *p) {
+    return p->symbol;
+}
+
+/**
+ * @brief Gets the visited flag of a valid point, without checks.
+ *
+ * @param p Point pointer, not NULL
+ *
+ * @return Returns the visited flag
+ */
+static inline Bool point_getVisitedUnchecked (const Point *p) {
+    return p->visited;
+}
+
+/**
+ * @brief Modifies the visited flag of a valid point, without checks.
+ *
+ * @param p Point pointer, not NULL
+ * @param bol New visited flag, TRUE or FALSE
+ */
+static inline void point_setVisitedUnchecked (Point *p, Bool bol) {
+    p->visited = bol;
+}
+
+#endif /* POINT_INLINE_H */
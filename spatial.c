@@ -0,0 +1,574 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "spatial.h"
+
+/* Copia de las coordenadas de cada punto, para no llamar a los getters en las consultas */
+typedef struct {
+    int32_t x, y;
+    const Point *p;
+} SpatialItem;
+
+/* Monticulo de maximos con los k mejores candidatos de una consulta */
+typedef struct {
+    int64_t *keys; // cuadrado de la distancia de cada candidato
+    const Point **pts;
+    size_t size, k;
+} SpatialBest;
+
+struct _PointGrid {
+    int32_t minx, miny; // esquina de la celda (0, 0)
+    int32_t cell; // lado de las celdas
+    size_t gw, gh; // numero de celdas en x e y
+    size_t *start; // items de la celda c: items[start[c]] .. items[start[c+1]-1]
+    SpatialItem *items; // puntos ordenados por celda
+    size_t n;
+};
+
+struct _KdTree {
+    size_t n;
+    SpatialItem *items; // arbol implicito: la raiz de [lo, hi) es (lo + hi) / 2, con ejes alternos
+};
+
+static int64_t _spatial_dist2 (const SpatialItem *it, int64_t qx, int64_t qy) {
+    int64_t dx = it->x - qx, dy = it->y - qy;
+
+    return dx*dx + dy*dy;
+}
+
+static SpatialItem * _spatial_copyItems (const Point * const *pts, size_t n) {
+    SpatialItem *items;
+    size_t i;
+
+    items = (SpatialItem*) malloc((n > 0 ? n : 1) * sizeof(SpatialItem));
+    if(!items) {
+        return NULL;
+    }
+
+    for(i=0; i < n; i++) {
+        if(!pts[i]) {
+            free(items);
+            return NULL;
+        }
+        items[i].x = point_getCoordinateX(pts[i]);
+        items[i].y = point_getCoordinateY(pts[i]);
+        items[i].p = pts[i];
+    }
+
+    return items;
+}
+
+static void _spatial_bestDown (SpatialBest *b, size_t i, size_t n) {
+    size_t child;
+    int64_t key = b->keys[i];
+    const Point *p = b->pts[i];
+
+    while((child = 2*i + 1) < n) {
+        if(child + 1 < n && b->keys[child + 1] > b->keys[child]) {
+            child++;
+        }
+        if(key >= b->keys[child]) {
+            break;
+        }
+        b->keys[i] = b->keys[child];
+        b->pts[i] = b->pts[child];
+        i = child;
+    }
+    b->keys[i] = key;
+    b->pts[i] = p;
+}
+
+/* Peor distancia que todavia puede entrar entre los k mejores */
+static int64_t _spatial_bestBound (const SpatialBest *b) {
+    return b->size < b->k ? INT64_MAX : b->keys[0];
+}
+
+static void _spatial_bestPush (SpatialBest *b, int64_t key, const Point *p) {
+    size_t i, parent;
+
+    if(b->size < b->k) {
+        //subir el nuevo candidato
+        i = b->size++;
+        while(i > 0 && b->keys[parent = (i - 1) / 2] < key) {
+            b->keys[i] = b->keys[parent];
+            b->pts[i] = b->pts[parent];
+            i = parent;
+        }
+        b->keys[i] = key;
+        b->pts[i] = p;
+    }
+    else if(key < b->keys[0]) {
+        b->keys[0] = key;
+        b->pts[0] = p;
+        _spatial_bestDown(b, 0, b->size);
+    }
+}
+
+/* Prepara b para k candidatos; si k == 1 no reserva memoria */
+static Status _spatial_bestInit (SpatialBest *b, size_t k, int64_t *key1, const Point **pt1) {
+    b->size = 0;
+    b->k = k;
+    if(k == 1) {
+        b->keys = key1;
+        b->pts = pt1;
+        return OK;
+    }
+
+    b->keys = (int64_t*) malloc(k * sizeof(int64_t));
+    b->pts = (const Point**) malloc(k * sizeof(const Point*));
+    if(!b->keys || !b->pts) {
+        free(b->keys);
+        free(b->pts);
+        return ERROR;
+    }
+
+    return OK;
+}
+
+/* Saca los candidatos en orden creciente de distancia y libera b */
+static int _spatial_bestFinish (SpatialBest *b, const Point **out) {
+    size_t i, n = b->size;
+    int64_t key;
+    const Point *p;
+
+    for(i=n; i > 0; i--) {
+        key = b->keys[0];
+        p = b->pts[0];
+        b->keys[0] = b->keys[i - 1];
+        b->pts[0] = b->pts[i - 1];
+        _spatial_bestDown(b, 0, i - 1);
+        b->keys[i - 1] = key;
+        out[i - 1] = p;
+    }
+
+    if(b->k > 1) {
+        free(b->keys);
+        free(b->pts);
+    }
+
+    return (int) n;
+}
+
+//Rejilla uniforme
+
+/* Celda de la coordenada v en un eje con origen o y n celdas, limitada a la rejilla */
+static size_t _pointgrid_cellOf (const PointGrid *g, int64_t v, int64_t o, size_t n) {
+    int64_t c;
+
+    if(v < o) {
+        return 0;
+    }
+    c = (v - o) / g->cell;
+
+    return (size_t) c >= n ? n - 1 : (size_t) c;
+}
+
+PointGrid * pointgrid_new (const Point * const *pts, size_t n, int cell) {
+    PointGrid *g;
+    SpatialItem *items;
+    size_t i, c, cells;
+    int32_t maxx, maxy;
+    int min_cell;
+    double area;
+
+    if((n > 0 && !pts) || cell < 0 || n > (size_t)__INT_MAX__) {
+        return NULL;
+    }
+
+    items = _spatial_copyItems(pts, n);
+    if(!items) {
+        return NULL;
+    }
+
+    g = (PointGrid*) malloc(sizeof(PointGrid));
+    if(!g) {
+        free(items);
+        return NULL;
+    }
+
+    //caja que contiene a todos los puntos
+    g->n = n;
+    g->minx = g->miny = 0;
+    maxx = maxy = 0;
+    for(i=0; i < n; i++) {
+        if(i == 0 || items[i].x < g->minx) g->minx = items[i].x;
+        if(i == 0 || items[i].y < g->miny) g->miny = items[i].y;
+        if(i == 0 || items[i].x > maxx) maxx = items[i].x;
+        if(i == 0 || items[i].y > maxy) maxy = items[i].y;
+    }
+
+    //por defecto unos dos puntos por celda; nunca mas de unas 4n celdas
+    area = ((double) maxx - g->minx + 1) * ((double) maxy - g->miny + 1);
+    min_cell = (int) ceil(sqrt(area / (4.0 * (double) n + 16.0)));
+    if(cell == 0) {
+        cell = (int) ceil(sqrt(2.0 * area / (n > 0 ? (double) n : 1.0)));
+    }
+    if(cell < min_cell) cell = min_cell;
+    if(cell < 1) cell = 1;
+    g->cell = cell;
+    g->gw = (size_t)(((int64_t) maxx - g->minx) / cell) + 1;
+    g->gh = (size_t)(((int64_t) maxy - g->miny) / cell) + 1;
+    cells = g->gw * g->gh;
+
+    g->start = (size_t*) calloc(cells + 1, sizeof(size_t));
+    g->items = (SpatialItem*) malloc((n > 0 ? n : 1) * sizeof(SpatialItem));
+    if(!g->start || !g->items) {
+        free(items);
+        pointgrid_free(g);
+        return NULL;
+    }
+
+    //ordenacion por cuentas: los puntos de cada celda quedan seguidos
+    for(i=0; i < n; i++) {
+        c = _pointgrid_cellOf(g, items[i].y, g->miny, g->gh) * g->gw + _pointgrid_cellOf(g, items[i].x, g->minx, g->gw);
+        g->start[c + 1]++;
+    }
+    for(c=0; c < cells; c++) {
+        g->start[c + 1] += g->start[c];
+    }
+    for(i=0; i < n; i++) {
+        c = _pointgrid_cellOf(g, items[i].y, g->miny, g->gh) * g->gw + _pointgrid_cellOf(g, items[i].x, g->minx, g->gw);
+        g->items[g->start[c]++] = items[i];
+    }
+    //start[c] ha quedado en el final de la celda c, es decir, el inicio de c+1
+    for(c=cells; c > 0; c--) {
+        g->start[c] = g->start[c - 1];
+    }
+    g->start[0] = 0;
+
+    free(items);
+    return g;
+}
+
+void pointgrid_free (PointGrid *g) {
+    if(!g) {
+        return;
+    }
+
+    free(g->start);
+    free(g->items);
+    free(g);
+}
+
+/* Mete en b los puntos de la celda (cx, cy) */
+static void _pointgrid_scanCell (const PointGrid *g, size_t cx, size_t cy, int64_t qx, int64_t qy, SpatialBest *b) {
+    size_t i, c = cy * g->gw + cx;
+
+    for(i=g->start[c]; i < g->start[c + 1]; i++) {
+        _spatial_bestPush(b, _spatial_dist2(&g->items[i], qx, qy), g->items[i].p);
+    }
+}
+
+static void _pointgrid_knn (const PointGrid *g, int64_t qx, int64_t qy, SpatialBest *b) {
+    int64_t cx, cy, r, x, y, x0, x1, y0, y1, lb, rmax;
+
+    cx = (int64_t) _pointgrid_cellOf(g, qx, g->minx, g->gw);
+    cy = (int64_t) _pointgrid_cellOf(g, qy, g->miny, g->gh);
+
+    //radio a partir del cual se han visitado todas las celdas
+    rmax = cx;
+    if((int64_t) g->gw - 1 - cx > rmax) rmax = (int64_t) g->gw - 1 - cx;
+    if(cy > rmax) rmax = cy;
+    if((int64_t) g->gh - 1 - cy > rmax) rmax = (int64_t) g->gh - 1 - cy;
+
+    for(r=0; r <= rmax; r++) {
+        //cota inferior de la distancia a cualquier punto fuera de los anillos ya vistos
+        if(r > 0 && b->size == b->k) {
+            x0 = g->minx + (cx - r + 1) * g->cell;
+            x1 = g->minx + (cx + r) * g->cell;
+            y0 = g->miny + (cy - r + 1) * g->cell;
+            y1 = g->miny + (cy + r) * g->cell;
+            if(qx >= x0 && qx < x1 && qy >= y0 && qy < y1) {
+                lb = qx - x0 + 1;
+                if(x1 - qx < lb) lb = x1 - qx;
+                if(qy - y0 + 1 < lb) lb = qy - y0 + 1;
+                if(y1 - qy < lb) lb = y1 - qy;
+                if(lb*lb > _spatial_bestBound(b)) {
+                    return;
+                }
+            }
+        }
+
+        for(y=cy - r; y <= cy + r; y++) {
+            if(y < 0 || y >= (int64_t) g->gh) {
+                continue;
+            }
+            if(y == cy - r || y == cy + r) {
+                for(x=cx - r; x <= cx + r; x++) {
+                    if(x >= 0 && x < (int64_t) g->gw) {
+                        _pointgrid_scanCell(g, (size_t) x, (size_t) y, qx, qy, b);
+                    }
+                }
+            }
+            else {
+                if(cx - r >= 0) {
+                    _pointgrid_scanCell(g, (size_t)(cx - r), (size_t) y, qx, qy, b);
+                }
+                if(cx + r < (int64_t) g->gw) {
+                    _pointgrid_scanCell(g, (size_t)(cx + r), (size_t) y, qx, qy, b);
+                }
+            }
+        }
+    }
+}
+
+const Point * pointgrid_nearest (const PointGrid *g, const Point *ref) {
+    const Point *best = NULL;
+
+    if(pointgrid_nearestK(g, ref, 1, &best) != 1) {
+        return NULL;
+    }
+
+    return best;
+}
+
+int pointgrid_nearestK (const PointGrid *g, const Point *ref, size_t k, const Point **out) {
+    SpatialBest b;
+    int64_t key1;
+    const Point *pt1;
+
+    if(!g || !ref || (k > 0 && !out) || k > (size_t)__INT_MAX__) {
+        return -1;
+    }
+
+    if(k > g->n) k = g->n;
+    if(k == 0) return 0;
+
+    if(_spatial_bestInit(&b, k, &key1, &pt1) == ERROR) {
+        return -1;
+    }
+    _pointgrid_knn(g, point_getCoordinateX(ref), point_getCoordinateY(ref), &b);
+
+    return _spatial_bestFinish(&b, out);
+}
+
+int pointgrid_radius (const PointGrid *g, const Point *ref, double r, const Point **out, size_t cap) {
+    int64_t qx, qy, ir;
+    size_t x, y, x0, x1, y0, y1, i, c, found = 0;
+
+    if(!g || !ref || r < 0 || (cap > 0 && !out)) {
+        return -1;
+    }
+
+    if(g->n == 0) return 0;
+
+    qx = point_getCoordinateX(ref);
+    qy = point_getCoordinateY(ref);
+    ir = r < 4e9 ? (int64_t) r : (int64_t) 4e9; // mas que cualquier diferencia de dos int
+
+    //si el cuadrado del circulo cae fuera de la caja no hay nada
+    if(qx + ir < g->minx || qy + ir < g->miny
+        || qx - ir >= g->minx + (int64_t) g->gw * g->cell || qy - ir >= g->miny + (int64_t) g->gh * g->cell) {
+        return 0;
+    }
+
+    x0 = _pointgrid_cellOf(g, qx - ir, g->minx, g->gw);
+    x1 = _pointgrid_cellOf(g, qx + ir, g->minx, g->gw);
+    y0 = _pointgrid_cellOf(g, qy - ir, g->miny, g->gh);
+    y1 = _pointgrid_cellOf(g, qy + ir, g->miny, g->gh);
+
+    for(y=y0; y <= y1; y++) {
+        for(x=x0; x <= x1; x++) {
+            c = y * g->gw + x;
+            for(i=g->start[c]; i < g->start[c + 1]; i++) {
+                if((double) _spatial_dist2(&g->items[i], qx, qy) <= r * r) {
+                    if(found < cap) {
+                        out[found] = g->items[i].p;
+                    }
+                    found++;
+                }
+            }
+        }
+    }
+
+    return found > (size_t)__INT_MAX__ ? __INT_MAX__ : (int) found;
+}
+
+//Arbol k-d
+
+static int32_t _kdtree_coord (const SpatialItem *it, int axis) {
+    return axis == 0 ? it->x : it->y;
+}
+
+/* Deja en items[k] el elemento que iria ahi si [lo, hi) estuviera ordenado por axis */
+static void _kdtree_select (SpatialItem *items, size_t lo, size_t hi, size_t k, int axis) {
+    size_t i, j;
+    int32_t pivot;
+    SpatialItem aux;
+
+    while(hi - lo > 1) {
+        //particion de Hoare con el pivote en el centro (por abajo)
+        pivot = _kdtree_coord(&items[lo + (hi - lo - 1) / 2], axis);
+        i = lo;
+        j = hi - 1;
+        for(;;) {
+            while(_kdtree_coord(&items[i], axis) < pivot) i++;
+            while(_kdtree_coord(&items[j], axis) > pivot) j--;
+            if(i >= j) {
+                break;
+            }
+            aux = items[i];
+            items[i] = items[j];
+            items[j] = aux;
+            i++;
+            j--;
+        }
+
+        if(k <= j) {
+            hi = j + 1;
+        }
+        else {
+            lo = j + 1;
+        }
+    }
+}
+
+static void _kdtree_build (SpatialItem *items, size_t lo, size_t hi, int axis) {
+    size_t mid;
+
+    while(hi - lo > 1) {
+        mid = lo + (hi - lo) / 2;
+        _kdtree_select(items, lo, hi, mid, axis);
+        _kdtree_build(items, lo, mid, !axis);
+        lo = mid + 1;
+        axis = !axis;
+    }
+}
+
+KdTree * kdtree_new (const Point * const *pts, size_t n) {
+    KdTree *t;
+
+    if((n > 0 && !pts) || n > (size_t)__INT_MAX__) {
+        return NULL;
+    }
+
+    t = (KdTree*) malloc(sizeof(KdTree));
+    if(!t) {
+        return NULL;
+    }
+
+    t->n = n;
+    t->items = _spatial_copyItems(pts, n);
+    if(!t->items) {
+        free(t);
+        return NULL;
+    }
+
+    _kdtree_build(t->items, 0, n, 0);
+
+    return t;
+}
+
+void kdtree_free (KdTree *t) {
+    if(!t) {
+        return;
+    }
+
+    free(t->items);
+    free(t);
+}
+
+static void _kdtree_knn (const KdTree *t, size_t lo, size_t hi, int axis, int64_t qx, int64_t qy, SpatialBest *b) {
+    size_t mid;
+    int64_t diff;
+    const SpatialItem *it;
+
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        it = &t->items[mid];
+        _spatial_bestPush(b, _spatial_dist2(it, qx, qy), it->p);
+
+        //primero el lado de la consulta; el otro solo si el plano esta mas cerca que el peor candidato
+        diff = (axis == 0 ? qx : qy) - _kdtree_coord(it, axis);
+        if(diff < 0) {
+            _kdtree_knn(t, lo, mid, !axis, qx, qy, b);
+            if(diff*diff >= _spatial_bestBound(b)) {
+                return;
+            }
+            lo = mid + 1;
+        }
+        else {
+            _kdtree_knn(t, mid + 1, hi, !axis, qx, qy, b);
+            if(diff*diff >= _spatial_bestBound(b)) {
+                return;
+            }
+            hi = mid;
+        }
+        axis = !axis;
+    }
+}
+
+const Point * kdtree_nearest (const KdTree *t, const Point *ref) {
+    const Point *best = NULL;
+
+    if(kdtree_nearestK(t, ref, 1, &best) != 1) {
+        return NULL;
+    }
+
+    return best;
+}
+
+int kdtree_nearestK (const KdTree *t, const Point *ref, size_t k, const Point **out) {
+    SpatialBest b;
+    int64_t key1;
+    const Point *pt1;
+
+    if(!t || !ref || (k > 0 && !out) || k > (size_t)__INT_MAX__) {
+        return -1;
+    }
+
+    if(k > t->n) k = t->n;
+    if(k == 0) return 0;
+
+    if(_spatial_bestInit(&b, k, &key1, &pt1) == ERROR) {
+        return -1;
+    }
+    _kdtree_knn(t, 0, t->n, 0, point_getCoordinateX(ref), point_getCoordinateY(ref), &b);
+
+    return _spatial_bestFinish(&b, out);
+}
+
+static void _kdtree_radius (const KdTree *t, size_t lo, size_t hi, int axis, int64_t qx, int64_t qy, double r2, const Point **out, size_t cap, size_t *found) {
+    size_t mid;
+    int64_t diff;
+    const SpatialItem *it;
+
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        it = &t->items[mid];
+        if((double) _spatial_dist2(it, qx, qy) <= r2) {
+            if(*found < cap) {
+                out[*found] = it->p;
+            }
+            (*found)++;
+        }
+
+        diff = (axis == 0 ? qx : qy) - _kdtree_coord(it, axis);
+        //el lado de la consulta siempre, el otro si el circulo corta el plano
+        if(diff < 0) {
+            if((double)(diff*diff) <= r2) {
+                _kdtree_radius(t, mid + 1, hi, !axis, qx, qy, r2, out, cap, found);
+            }
+            hi = mid;
+        }
+        else {
+            if((double)(diff*diff) <= r2) {
+                _kdtree_radius(t, lo, mid, !axis, qx, qy, r2, out, cap, found);
+            }
+            lo = mid + 1;
+        }
+        axis = !axis;
+    }
+}
+
+int kdtree_radius (const KdTree *t, const Point *ref, double r, const Point **out, size_t cap) {
+    size_t found = 0;
+
+    if(!t || !ref || r < 0 || (cap > 0 && !out)) {
+        return -1;
+    }
+
+    _kdtree_radius(t, 0, t->n, 0, point_getCoordinateX(ref), point_getCoordinateY(ref), r * r, out, cap, &found);
+
+    return found > (size_t)__INT_MAX__ ? __INT_MAX__ : (int) found;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file  spatial.h
+ * @brief Spatial indices over sets of points
+ *
+ * @details Two indices that answer nearest neighbour, k nearest 
+ * neighbours and radius queries without looking at every point:
+ * - PointGrid: uniform grid of buckets over the bounding box of the 
+ *   points, best for bounded coordinates (for instance 0..MAX_RAND).
+ * - KdTree: balanced 2-d tree, for any distribution of the points.
+ *
+ * Both are built once from an array of points, in O(n) and O(n log n),
+ * and keep pointers to them: the points must not be freed or moved 
+ * while the index is in use. Distances are compared exactly, as 64-bit
+ * squared distances, like point_cmpEuDistanceTo.
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stddef.h>
+#include "types.h"
+#include "point.h"
+
+typedef struct _PointGrid PointGrid;
+typedef struct _KdTree KdTree;
+
+/**
+ * @brief Builds a uniform grid over an array of points.
+ *
+ * @param pts Array of n points
+ * @param n Number of points
+ * @param cell Side of the cells; 0 to choose it so that there are 
+ * about two points per cell. It is enlarged if the grid would have 
+ * many more cells than points.
+ *
+ * @return The new grid or NULL in case of error.
+ */
+PointGrid * pointgrid_new (const Point * const *pts, size_t n, int cell);
+
+/**
+ * @brief Frees a grid (not the points).
+ *
+ * @param g Pointer to the grid
+ */
+void pointgrid_free (PointGrid *g);
+
+/**
+ * @brief Finds the point of the grid closest to ref.
+ *
+ * Visits the cells in rings around the cell of ref until no closer 
+ * point can appear.
+ *
+ * @param g Pointer to the grid
+ * @param ref Query point, it can be outside the grid
+ *
+ * @return The closest point, or NULL if the grid is empty or in case
+ * of error.
+ */
+const Point * pointgrid_nearest (const PointGrid *g, const Point *ref);
+
+/**
+ * @brief Finds the k points of the grid closest to ref.
+ *
+ * @param g Pointer to the grid
+ * @param ref Query point
+ * @param k Number of points wanted
+ * @param out Array with room for k points, where they are stored in 
+ * increasing order of distance
+ *
+ * @return Returns the number of points stored, min(n, k), or -1 in 
+ * case of error.
+ */
+int pointgrid_nearestK (const PointGrid *g, const Point *ref, size_t k, const Point **out);
+
+/**
+ * @brief Finds the points of the grid at distance at most r from ref.
+ *
+ * @param g Pointer to the grid
+ * @param ref Query point
+ * @param r Radius, not negative
+ * @param out Array where the first cap points found are stored, in no
+ * particular order (it can be NULL if cap is 0)
+ * @param cap Size of out
+ *
+ * @return Returns the number of points in the circle, which can be 
+ * greater than cap, or -1 in case of error.
+ */
+int pointgrid_radius (const PointGrid *g, const Point *ref, double r, const Point **out, size_t cap);
+
+/**
+ * @brief Builds a balanced k-d tree over an array of points.
+ *
+ * @param pts Array of n points
+ * @param n Number of points
+ *
+ * @return The new tree or NULL in case of error.
+ */
+KdTree * kdtree_new (const Point * const *pts, size_t n);
+
+/**
+ * @brief Frees a k-d tree (not the points).
+ *
+ * @param t Pointer to the tree
+ */
+void kdtree_free (KdTree *t);
+
+/**
+ * @brief Finds the point of the tree closest to ref.
+ *
+ * @param t Pointer to the tree
+ * @param ref Query point
+ *
+ * @return The closest point, or NULL if the tree is empty or in case
+ * of error.
+ */
+const Point * kdtree_nearest (const KdTree *t, const Point *ref);
+
+/**
+ * @brief Finds the k points of the tree closest to ref.
+ *
+ * @param t Pointer to the tree
+ * @param ref Query point
+ * @param k Number of points wanted
+ * @param out Array with room for k points, where they are stored in 
+ * increasing order of distance
+ *
+ * @return Returns the number of points stored, min(n, k), or -1 in 
+ * case of error.
+ */
+int kdtree_nearestK (const KdTree *t, const Point *ref, size_t k, const Point **out);
+
+/**
+ * @brief Finds the points of the tree at distance at most r from ref.
+ *
+ * @param t Pointer to the tree
+ * @param ref Query point
+ * @param r Radius, not negative
+ * @param out Array where the first cap points found are stored, in no
+ * particular order (it can be NULL if cap is 0)
+ * @param cap Size of out
+ *
+ * @return Returns the number of points in the circle, which can be 
+ * greater than cap, or -1 in case of error.
+ */
+int kdtree_radius (const KdTree *t, const Point *ref, double r, const Point **out, size_t cap);
+
+#endif /* SPATIAL_H */
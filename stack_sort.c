@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "stack_sort.h"
+
+/* Rangos con menos elementos se ordenan por insercion */
+#define SORT_SMALL 16
+
+typedef struct {
+    uint64_t key; // cuadrado de la distancia
+    void *ele;
+} SortItem;
+
+/* Vacia la pila en un array: a[0] es el fondo y a[n-1] la cima */
+static void ** _stack_drain (Stack *s, size_t *n) {
+    void **a;
+    size_t i;
+
+    *n = stack_size(s);
+    a = (void **) malloc((*n > 0 ? *n : 1) * sizeof(void *));
+    if(!a) {
+        return NULL;
+    }
+
+    for(i=*n; i > 0; i--) {
+        a[i - 1] = stack_pop(s);
+    }
+
+    return a;
+}
+
+/* Vuelve a meter los elementos en la pila, a[n-1] queda en la cima; si 
+   falla un push la pila se queda solo con los anteriores */
+static Status _stack_refill (Stack *s, void **a, size_t n) {
+    size_t i;
+
+    for(i=0; i < n; i++) {
+        if(stack_push(s, a[i]) == ERROR) {
+            return ERROR;
+        }
+    }
+
+    return OK;
+}
+
+static void _sort_insertion (void **a, size_t n, P_stack_ele_cmp f) {
+    size_t i, j;
+    void *aux;
+
+    for(i=1; i < n; i++) {
+        aux = a[i];
+        for(j=i; j > 0 && f(a[j - 1], aux) > 0; j--) {
+            a[j] = a[j - 1];
+        }
+        a[j] = aux;
+    }
+}
+
+static void _sort_siftDown (void **a, size_t i, size_t n, P_stack_ele_cmp f) {
+    size_t child;
+    void *aux = a[i];
+
+    while((child = 2*i + 1) < n) {
+        if(child + 1 < n && f(a[child], a[child + 1]) < 0) {
+            child++;
+        }
+        if(f(aux, a[child]) >= 0) {
+            break;
+        }
+        a[i] = a[child];
+        i = child;
+    }
+    a[i] = aux;
+}
+
+static void _sort_heapsort (void **a, size_t n, P_stack_ele_cmp f) {
+    size_t i;
+    void *aux;
+
+    for(i=n/2; i > 0; i--) {
+        _sort_siftDown(a, i - 1, n, f);
+    }
+    for(i=n - 1; i > 0; i--) {
+        aux = a[0];
+        a[0] = a[i];
+        a[i] = aux;
+        _sort_siftDown(a, 0, i, f);
+    }
+}
+
+static void _sort_intro (void **a, size_t n, int depth, P_stack_ele_cmp f) {
+    size_t i, j, mid;
+    void *pivot, *aux;
+
+    while(n > SORT_SMALL) {
+        //demasiadas particiones malas: heapsort garantiza O(n log n)
+        if(depth-- == 0) {
+            _sort_heapsort(a, n, f);
+            return;
+        }
+
+        //mediana de tres como pivote, queda en a[mid]
+        mid = n / 2;
+        if(f(a[mid], a[0]) < 0) { aux = a[mid]; a[mid] = a[0]; a[0] = aux; }
+        if(f(a[n - 1], a[mid]) < 0) {
+            aux = a[mid]; a[mid] = a[n - 1]; a[n - 1] = aux;
+            if(f(a[mid], a[0]) < 0) { aux = a[mid]; a[mid] = a[0]; a[0] = aux; }
+        }
+        pivot = a[mid];
+
+        //particion de Hoare
+        i = 0;
+        j = n - 1;
+        for(;;) {
+            while(f(a[i], pivot) < 0) i++;
+            while(f(pivot, a[j]) < 0) j--;
+            if(i >= j) {
+                break;
+            }
+            aux = a[i]; a[i] = a[j]; a[j] = aux;
+            i++;
+            j--;
+        }
+
+        //recursion sobre la parte pequena, iteracion sobre la grande
+        if(j + 1 < n - j - 1) {
+            _sort_intro(a, j + 1, depth, f);
+            a += j + 1;
+            n -= j + 1;
+        }
+        else {
+            _sort_intro(a + j + 1, n - j - 1, depth, f);
+            n = j + 1;
+        }
+    }
+
+    _sort_insertion(a, n, f);
+}
+
+Status stack_sort (Stack *s, P_stack_ele_cmp f) {
+    void **a;
+    size_t n, m;
+    int depth = 0;
+
+    if(!s || !f) {
+        return ERROR;
+    }
+
+    a = _stack_drain(s, &n);
+    if(!a) {
+        return ERROR;
+    }
+
+    for(m=n; m > 1; m >>= 1) {
+        depth += 2;
+    }
+    _sort_intro(a, n, depth, f);
+
+    if(_stack_refill(s, a, n) == ERROR) {
+        free(a);
+        return ERROR;
+    }
+
+    free(a);
+    return OK;
+}
+
+Status stack_sortPoints (Stack *s, const Point *ref) {
+    SortItem *items, *tmp, *aux;
+    void **a;
+    size_t n, i, count[256], sum, c;
+    uint64_t max = 0;
+    int64_t dx, dy;
+    int shift, rx, ry;
+
+    if(!s || !ref) {
+        return ERROR;
+    }
+
+    rx = point_getCoordinateX(ref);
+    ry = point_getCoordinateY(ref);
+    n = stack_size(s);
+    items = (SortItem *) malloc((n > 0 ? n : 1) * sizeof(SortItem));
+    tmp = (SortItem *) malloc((n > 0 ? n : 1) * sizeof(SortItem));
+    if(!items || !tmp) {
+        free(items);
+        free(tmp);
+        return ERROR;
+    }
+
+    a = _stack_drain(s, &n);
+    if(!a) {
+        free(items);
+        free(tmp);
+        return ERROR;
+    }
+
+    //claves: cuadrados exactos de las distancias
+    for(i=0; i < n; i++) {
+        dx = (int64_t) point_getCoordinateX(a[i]) - rx;
+        dy = (int64_t) point_getCoordinateY(a[i]) - ry;
+        items[i].key = (uint64_t)(dx*dx + dy*dy);
+        items[i].ele = a[i];
+        if(items[i].key > max) {
+            max = items[i].key;
+        }
+    }
+
+    //radix LSD de 8 bits, solo los bytes que usa la clave mayor
+    for(shift=0; shift < 64 && (max >> shift) > 0; shift += 8) {
+        for(c=0; c < 256; c++) {
+            count[c] = 0;
+        }
+        for(i=0; i < n; i++) {
+            count[(items[i].key >> shift) & 0xFF]++;
+        }
+        for(c=0, sum=0; c < 256; c++) {
+            sum += count[c];
+            count[c] = sum - count[c];
+        }
+        for(i=0; i < n; i++) {
+            tmp[count[(items[i].key >> shift) & 0xFF]++] = items[i];
+        }
+        aux = items;
+        items = tmp;
+        tmp = aux;
+    }
+
+    for(i=0; i < n; i++) {
+        a[i] = items[i].ele;
+    }
+    free(items);
+    free(tmp);
+
+    if(_stack_refill(s, a, n) == ERROR) {
+        free(a);
+        return ERROR;
+    }
+
+    free(a);
+    return OK;
+}
+
+int stack_nearestK (Stack *s, const Point *ref, size_t k, const Point **out) {
+    void **a;
+    size_t n;
+    int found;
+
+    if(!s || !ref || (k > 0 && !out)) {
+        return -1;
+    }
+
+    //la pila solo se puede recorrer vaciandola
+    a = _stack_drain(s, &n);
+    if(!a) {
+        return -1;
+    }
+
+    found = point_nearestK(ref, (const Point * const *) a, n, k, out);
+
+    if(_stack_refill(s, a, n) == ERROR) {
+        found = -1;
+    }
+
+    free(a);
+    return found;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file  stack_sort.h
+ * @brief Sorting of the elements of a stack
+ *
+ * @details The elements are moved to a contiguous array, sorted there 
+ * in O(n log n) (introsort) or O(n) (radix sort on the squared distance
+ * of points) and pushed back. After sorting, the elements are in 
+ * increasing order from the bottom to the top of the stack: the top
+ * is the greatest one.
+ *
+ * When only the closest points are needed, stack_nearestK avoids 
+ * sorting the whole stack.
+ */
+
+#ifndef STACK_SORT_H
+#define STACK_SORT_H
+
+#include "types.h"
+#include "point.h"
+#include "stack_fDoble.h"
+
+/**
+ * @brief Typedef for a function pointer to compare two stack elements,
+ * with the convention of qsort (point_cmpEuDistance, for instance)
+ **/
+typedef int (*P_stack_ele_cmp)(const void *, const void *);
+
+/**
+ * @brief Sorts the elements of a stack with a comparison function.
+ *
+ * Uses introsort (quicksort with median of three, heapsort when the 
+ * recursion gets too deep and insertion sort for small ranges), so it
+ * takes O(n log n) comparisons in the worst case. It is not stable.
+ *
+ * @code
+ * stack_sort (s, point_cmpEuDistance);
+ * @endcode
+ *
+ * @param s Pointer to the stack
+ * @param f Comparison function
+ *
+ * @return OK or ERROR if the parameters are not valid or there is not
+ * enough memory. The stack is not modified if the parameters are not 
+ * valid or the elements cannot be copied out of it; if they cannot be
+ * pushed back, its contents are unspecified.
+ */
+Status stack_sort (Stack *s, P_stack_ele_cmp f);
+
+/**
+ * @brief Sorts a stack of points by their euclidean distance to ref.
+ *
+ * Sorts with a radix sort on the exact squared distances, only over
+ * the bytes the greatest distance uses (two passes for coordinates 
+ * below 128). Points at the same distance keep their relative order.
+ *
+ * @param s Pointer to a stack of points
+ * @param ref Reference point, for instance (0, 0)
+ *
+ * @return OK or ERROR if the parameters are not valid or there is not
+ * enough memory. The stack is not modified if the parameters are not 
+ * valid or the elements cannot be copied out of it; if they cannot be
+ * pushed back, its contents are unspecified.
+ */
+Status stack_sortPoints (Stack *s, const Point *ref);
+
+/**
+ * @brief Finds the k points of a stack closest to ref.
+ *
+ * Runs point_nearestK over the elements of the stack, which is left 
+ * as it was (except on error, when the elements cannot be pushed back
+ * and its contents are unspecified, as in stack_sort).
+ *
+ * @param s Pointer to a stack of points
+ * @param ref Reference point
+ * @param k Number of points wanted
+ * @param out Array with room for k points, where the closest ones are 
+ * stored in increasing order of distance
+ *
+ * @return Returns the number of points stored, min(size, k), or -1 in 
+ * case of error.
+ */
+int stack_nearestK (Stack *s, const Point *ref, size_t k, const Point **out);
+
+#endif /* STACK_SORT_H */